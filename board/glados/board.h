@@ -33,6 +33,7 @@
 #define CONFIG_CHIPSET_SKYLAKE
 #define CONFIG_CLOCK_CRYSTAL
 #define CONFIG_EXTPOWER_GPIO
+#define CONFIG_HOSTCMD_BATCH
 #define CONFIG_HOSTCMD_PD
 #define CONFIG_I2C
 #define CONFIG_KEYBOARD_PROTOCOL_8042
@@ -87,7 +87,7 @@
 #undef CONFIG_UART_RX_DMA
 
 #undef  DEFERRABLE_MAX_COUNT
-#define DEFERRABLE_MAX_COUNT 11
+#define DEFERRABLE_MAX_COUNT 12
 
 /*
  * Allow dangerous commands.
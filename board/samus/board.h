@@ -62,6 +62,7 @@
 #define CONFIG_HIBERNATE_DELAY_SEC (3600 * 24 * 7)
 #define CONFIG_HIBERNATE_BATT_PCT 10
 #define CONFIG_HIBERNATE_BATT_SEC (3600 * 24)
+#define CONFIG_HOSTCMD_BATCH
 #define CONFIG_HOSTCMD_PD
 #define CONFIG_HOSTCMD_PD_CHG_CTRL
 #define CONFIG_HOSTCMD_PD_PANIC
@@ -0,0 +1,3 @@
+/* This file is generated by util/getdate.sh */
+/* DATE is used to form build info string in common/version.c. */
+#define DATE "2026-10-17 03:27:39"
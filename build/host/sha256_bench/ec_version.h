@@ -0,0 +1,17 @@
+/* This file is generated by util/getversion.sh */
+/* Version string for use by common/version.c */
+#ifdef SHIFT_CODE_FOR_TEST
+#define CROS_EC_VERSION "host_v0.0.43-68e3827-dirty_shift"
+#else
+#define CROS_EC_VERSION "host_v0.0.43-68e3827-dirty"
+#endif
+/* Version string, truncated to 31 chars (+ terminating null = 32) */
+#define CROS_EC_VERSION32 "host_v0.0.43-68e3827-dirty"
+/* Sub-fields for use in Makefile.rules and to form build info string
+ * in common/version.c. */
+#define VERSION "host_v0.0.43-68e3827-dirty"
+#define BUILDER "@vm"
+/* Author date of last commit, in case compile-time is not used. */
+#ifndef DATE
+#define DATE "2026-10-17 03:27:16"
+#endif
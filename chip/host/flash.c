@@ -6,13 +6,25 @@
 /* Flash module for emulator */
 
 #include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "common.h"
 #include "flash.h"
 #include "persistence.h"
 #include "util.h"
 
-char __host_flash[CONFIG_FLASH_PHYSICAL_SIZE];
+/*
+ * The flash array is replaced by a shared mapping of the persistent storage
+ * file, so it must start on a page boundary.  64KB covers every host page
+ * size we run on.  Writes and erases land in the file through the mapping;
+ * there is nothing to write back by hand.
+ */
+#define HOST_FLASH_ALIGN 0x10000
+BUILD_ASSERT(CONFIG_FLASH_PHYSICAL_SIZE % HOST_FLASH_ALIGN == 0);
+
+char __host_flash[CONFIG_FLASH_PHYSICAL_SIZE] __aligned(HOST_FLASH_ALIGN);
 uint8_t __host_flash_protect[PHYSICAL_BANKS];
 
 /* Override this function to make flash erase/write operation fail */
@@ -34,33 +46,36 @@ static int flash_check_protect(int offset, int size)
 	return 0;
 }
 
-static void flash_set_persistent(void)
+static void flash_get_persistent(void)
 {
-	FILE *f = get_persistent_storage("flash", "wb");
-	int sz;
+	FILE *f = get_persistent_storage("flash", "a+b");
+	struct stat st;
+	void *p;
+	int rv;
 
 	ASSERT(f != NULL);
 
-	sz = fwrite(__host_flash, sizeof(__host_flash), 1, f);
-	ASSERT(sz == 1);
+	rv = fstat(fileno(f), &st);
+	ASSERT(rv == 0);
 
-	release_persistent_storage(f);
-}
+	if (st.st_size < sizeof(__host_flash)) {
+		rv = ftruncate(fileno(f), sizeof(__host_flash));
+		ASSERT(rv == 0);
+	}
 
-static void flash_get_persistent(void)
-{
-	FILE *f = get_persistent_storage("flash", "rb");
+	p = mmap(__host_flash, sizeof(__host_flash), PROT_READ | PROT_WRITE,
+		 MAP_SHARED | MAP_FIXED, fileno(f), 0);
+	ASSERT(p == __host_flash);
+
+	/* The mapping stays valid after the file is closed */
+	release_persistent_storage(f);
 
-	if (f == NULL) {
+	if (st.st_size < sizeof(__host_flash)) {
 		fprintf(stderr,
 			"No flash storage found. Initializing to 0xff.\n");
-		memset(__host_flash, 0xff, sizeof(__host_flash));
-		return;
+		memset(__host_flash + st.st_size, 0xff,
+		       sizeof(__host_flash) - st.st_size);
 	}
-
-	fread(__host_flash, sizeof(__host_flash), 1, f);
-
-	release_persistent_storage(f);
 }
 
 int flash_physical_write(int offset, int size, const char *data)
@@ -74,7 +89,6 @@ int flash_physical_write(int offset, int size, const char *data)
 		return EC_ERROR_ACCESS_DENIED;
 
 	memcpy(__host_flash + offset, data, size);
-	flash_set_persistent();
 
 	return EC_SUCCESS;
 }
@@ -90,7 +104,6 @@ int flash_physical_erase(int offset, int size)
 		return EC_ERROR_ACCESS_DENIED;
 
 	memset(__host_flash + offset, 0xff, size);
-	flash_set_persistent();
 
 	return EC_SUCCESS;
 }
@@ -0,0 +1,220 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/*
+ * Host command interface for the emulator.
+ *
+ * Serves protocol version 3 host packets on a Unix socket, so that ectool
+ * and other host tools can talk to the emulator.  The host writes a request
+ * packet (header and params), and reads back a response packet (header and
+ * data).  One request is handled at a time.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "hooks.h"
+#include "host_command.h"
+#include "task.h"
+#include "test_util.h"
+
+/* Biggest packet the socket handles, including the header */
+#define HOST_SOCKET_PACKET_SIZE 0x100
+
+static const char *socket_path;
+static pthread_t socket_thread;
+
+static uint8_t request_buf[HOST_SOCKET_PACKET_SIZE] __aligned(4);
+static uint8_t response_buf[HOST_SOCKET_PACKET_SIZE] __aligned(4);
+static struct host_packet socket_packet;
+
+/* Set by the emulated interrupt once it has taken the packet */
+static volatile int packet_received;
+/* Posted when the response is ready */
+static sem_t response_sem;
+
+void emulator_set_host_socket(const char *path)
+{
+	socket_path = path;
+}
+
+static void socket_send_response(struct host_packet *pkt)
+{
+	sem_post(&response_sem);
+}
+
+static void socket_interrupt(void)
+{
+	host_packet_receive(&socket_packet);
+	packet_received = 1;
+}
+
+/* Read exactly size bytes; returns 0 if ok, or non-zero at end of file */
+static int read_all(int fd, uint8_t *buf, int size)
+{
+	int rv;
+
+	while (size) {
+		rv = read(fd, buf, size);
+		if (rv < 0 && errno == EINTR)
+			continue;
+		if (rv <= 0)
+			return 1;
+		buf += rv;
+		size -= rv;
+	}
+	return 0;
+}
+
+static int write_all(int fd, const uint8_t *buf, int size)
+{
+	int rv;
+
+	while (size) {
+		rv = write(fd, buf, size);
+		if (rv < 0 && errno == EINTR)
+			continue;
+		if (rv <= 0)
+			return 1;
+		buf += rv;
+		size -= rv;
+	}
+	return 0;
+}
+
+/* Handle requests from one connection until it's closed */
+static void serve_connection(int fd)
+{
+	const struct ec_host_request *r =
+		(const struct ec_host_request *)request_buf;
+	uint8_t discard;
+	int size, i;
+
+	while (!read_all(fd, request_buf, sizeof(*r))) {
+		size = sizeof(*r) + r->data_len;
+		socket_packet.driver_result = EC_RES_SUCCESS;
+		if (size > sizeof(request_buf)) {
+			/* Drop the params; the EC just returns an error */
+			for (i = sizeof(*r); i < size; i++)
+				if (read_all(fd, &discard, 1))
+					return;
+			socket_packet.driver_result =
+				EC_RES_REQUEST_TRUNCATED;
+			size = sizeof(*r);
+		} else if (read_all(fd, request_buf + sizeof(*r),
+				    size - sizeof(*r))) {
+			return;
+		}
+
+		socket_packet.send_response = socket_send_response;
+		socket_packet.request = request_buf;
+		socket_packet.request_temp = NULL;
+		socket_packet.request_max = sizeof(request_buf);
+		socket_packet.request_size = size;
+		socket_packet.response = response_buf;
+		socket_packet.response_max = sizeof(response_buf);
+		socket_packet.response_size = 0;
+
+		/*
+		 * Hand the packet over like a bus interrupt would.  The
+		 * interrupt is dropped if interrupts are disabled, so retry.
+		 */
+		packet_received = 0;
+		while (!packet_received) {
+			task_trigger_test_interrupt(socket_interrupt);
+			if (!packet_received)
+				usleep(1000);
+		}
+
+		while (sem_wait(&response_sem) && errno == EINTR)
+			;
+
+		if (write_all(fd, response_buf, socket_packet.response_size))
+			return;
+	}
+}
+
+static void *socket_serve(void *arg)
+{
+	int listen_fd = (int)(intptr_t)arg;
+	int fd;
+
+	while (1) {
+		fd = accept(listen_fd, NULL, NULL);
+		if (fd < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("host socket accept");
+			break;
+		}
+		serve_connection(fd);
+		close(fd);
+	}
+
+	close(listen_fd);
+	return NULL;
+}
+
+static void host_socket_init(void)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if (!socket_path)
+		return;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Host socket path too long\n");
+		return;
+	}
+	strcpy(addr.sun_path, socket_path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("host socket");
+		return;
+	}
+
+	/* Replace the socket left by an earlier run, or before a reboot */
+	unlink(socket_path);
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) ||
+	    listen(fd, 1)) {
+		perror("host socket bind");
+		close(fd);
+		return;
+	}
+
+	sem_init(&response_sem, 0, 0);
+	pthread_create(&socket_thread, NULL, socket_serve,
+		       (void *)(intptr_t)fd);
+}
+DECLARE_HOOK(HOOK_INIT, host_socket_init, HOOK_PRIO_DEFAULT);
+
+static int host_socket_get_protocol_info(struct host_cmd_handler_args *args)
+{
+	struct ec_response_get_protocol_info *r = args->response;
+
+	memset(r, 0, sizeof(*r));
+	r->protocol_versions = (1 << 3);
+	r->max_request_packet_size = HOST_SOCKET_PACKET_SIZE;
+	r->max_response_packet_size = HOST_SOCKET_PACKET_SIZE;
+	r->flags = 0;
+
+	args->response_size = sizeof(*r);
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_GET_PROTOCOL_INFO,
+		     host_socket_get_protocol_info,
+		     EC_VER_MASK(0));
@@ -14,4 +14,7 @@
 /* Get emulator executable name */
 const char *__get_prog_name(void);
 
+/* Get emulator command line arguments, to be preserved across reboots */
+char **__get_prog_argv(void);
+
 #endif  /* __CROS_EC_HOST_TEST_H */
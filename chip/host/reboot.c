@@ -5,7 +5,6 @@
 
 /* Emulator self-reboot procedure */
 
-#include <string.h>
 #include <unistd.h>
 
 #include "host_test.h"
@@ -14,7 +13,6 @@
 
 void emulator_reboot(void)
 {
-	char *argv[] = {strdup(__get_prog_name()), NULL};
 	emulator_flush();
-	execv(__get_prog_name(), argv);
+	execv(__get_prog_name(), __get_prog_argv());
 }
@@ -69,6 +69,15 @@ static void trigger_interrupt(void)
 {
 	if (int_disabled)
 		return;
+
+	/*
+	 * Printing from another emulated interrupt (e.g. the host socket)
+	 * can't trigger a nested one, so handle the UART right away.
+	 */
+	if (in_interrupt_context()) {
+		uart_interrupt();
+		return;
+	}
 	task_trigger_test_interrupt(uart_interrupt);
 }
 
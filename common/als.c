@@ -25,13 +25,16 @@ void als_task(void)
 {
 	int i, val;
 	uint16_t *mapped = (uint16_t *)host_get_memmap(EC_MEMMAP_ALS);
-	uint16_t als_data;
+	uint16_t als_data[EC_ALS_ENTRIES];
 
 	while (1) {
-		for (i = 0; i < EC_ALS_ENTRIES && i < ALS_COUNT; i++) {
-			als_data = als_read(i, &val) == EC_SUCCESS ? val : 0;
-			mapped[i] = als_data;
-		}
+		for (i = 0; i < EC_ALS_ENTRIES && i < ALS_COUNT; i++)
+			als_data[i] = als_read(i, &val) == EC_SUCCESS ? val : 0;
+
+		host_memmap_update_begin();
+		for (i = 0; i < EC_ALS_ENTRIES && i < ALS_COUNT; i++)
+			mapped[i] = als_data[i];
+		host_memmap_update_end();
 
 		task_wait_event(SECOND);
 	}
@@ -39,6 +39,7 @@ common-$(CONFIG_COMMON_GPIO)+=gpio.o
 common-$(CONFIG_COMMON_PANIC_OUTPUT)+=panic_output.o
 common-$(CONFIG_COMMON_RUNTIME)+=hooks.o main.o system.o shared_mem.o
 common-$(CONFIG_COMMON_TIMER)+=timer.o
+common-$(CONFIG_CONSOLE_BINLOG)+=console_binlog.o
 common-$(CONFIG_CRC8)+= crc8.o
 common-$(CONFIG_PMU_POWERINFO)+=pmu_tps65090_powerinfo.o
 common-$(CONFIG_PMU_TPS65090)+=pmu_tps65090.o
@@ -80,6 +81,7 @@ common-$(CONFIG_SOFTWARE_CLZ)+=clz.o
 common-$(CONFIG_SPI_FLASH)+=spi_flash.o spi_flash_reg.o
 common-$(CONFIG_SWITCH)+=switch.o
 common-$(CONFIG_SW_CRC)+=crc.o
+common-$(CONFIG_TASK_STATS)+=task_stats.o
 common-$(CONFIG_TEMP_SENSOR)+=temp_sensor.o thermal.o throttle_ap.o
 common-$(CONFIG_TPM_SPS)+=tpm_registers.o
 common-$(CONFIG_USB_CHARGER)+=usb_charger.o
@@ -113,10 +113,24 @@ static void problem(enum problem_type p, int v)
 	problems_exist = 1;
 }
 
+/* Static battery info, laid out as it is in the memory map */
+struct static_battery_info {
+	int design_capacity;
+	int design_voltage;
+	int full_charge_capacity;
+	int cycle_count;
+	char manufacturer[EC_MEMMAP_TEXT_MAX];
+	char model[EC_MEMMAP_TEXT_MAX];
+	char serial[EC_MEMMAP_TEXT_MAX];
+	char type[EC_MEMMAP_TEXT_MAX];
+};
+BUILD_ASSERT(sizeof(struct static_battery_info) ==
+	     EC_MEMMAP_BATT_TYPE + EC_MEMMAP_TEXT_MAX - EC_MEMMAP_BATT_DCAP);
+
 /* Returns zero if every item was updated. */
 static int update_static_battery_info(void)
 {
-	char *batt_str;
+	struct static_battery_info info;
 	int batt_serial;
 	/*
 	 * The return values have type enum ec_error_list, but EC_SUCCESS is
@@ -124,41 +138,45 @@ static int update_static_battery_info(void)
 	 */
 	int rv;
 
+	/*
+	 * Read the battery into a copy first, so the memory map is only busy
+	 * for the copy and not for all the reads.  Items which can't be read
+	 * keep their old values, as they would if read in place.
+	 */
+	memcpy(&info, host_get_memmap(EC_MEMMAP_BATT_DCAP), sizeof(info));
+
 	/* Smart battery serial number is 16 bits */
-	batt_str = (char *)host_get_memmap(EC_MEMMAP_BATT_SERIAL);
-	memset(batt_str, 0, EC_MEMMAP_TEXT_MAX);
+	memset(info.serial, 0, EC_MEMMAP_TEXT_MAX);
 	rv = battery_serial_number(&batt_serial);
 	if (!rv)
-		snprintf(batt_str, EC_MEMMAP_TEXT_MAX, "%04X", batt_serial);
+		snprintf(info.serial, EC_MEMMAP_TEXT_MAX, "%04X", batt_serial);
 
 	/* Design Capacity of Full */
-	rv |= battery_design_capacity(
-		(int *)host_get_memmap(EC_MEMMAP_BATT_DCAP));
+	rv |= battery_design_capacity(&info.design_capacity);
 
 	/* Design Voltage */
-	rv |= battery_design_voltage(
-		(int *)host_get_memmap(EC_MEMMAP_BATT_DVLT));
+	rv |= battery_design_voltage(&info.design_voltage);
 
 	/* Last Full Charge Capacity (this is only mostly static) */
-	rv |= battery_full_charge_capacity(
-		(int *)host_get_memmap(EC_MEMMAP_BATT_LFCC));
+	rv |= battery_full_charge_capacity(&info.full_charge_capacity);
 
 	/* Cycle Count */
-	rv |= battery_cycle_count((int *)host_get_memmap(EC_MEMMAP_BATT_CCNT));
+	rv |= battery_cycle_count(&info.cycle_count);
 
 	/* Battery Manufacturer string */
-	batt_str = (char *)host_get_memmap(EC_MEMMAP_BATT_MFGR);
-	memset(batt_str, 0, EC_MEMMAP_TEXT_MAX);
-	rv |= battery_manufacturer_name(batt_str, EC_MEMMAP_TEXT_MAX);
+	memset(info.manufacturer, 0, EC_MEMMAP_TEXT_MAX);
+	rv |= battery_manufacturer_name(info.manufacturer, EC_MEMMAP_TEXT_MAX);
 
 	/* Battery Model string */
-	batt_str = (char *)host_get_memmap(EC_MEMMAP_BATT_MODEL);
-	memset(batt_str, 0, EC_MEMMAP_TEXT_MAX);
-	rv |= battery_device_name(batt_str, EC_MEMMAP_TEXT_MAX);
+	memset(info.model, 0, EC_MEMMAP_TEXT_MAX);
+	rv |= battery_device_name(info.model, EC_MEMMAP_TEXT_MAX);
 
 	/* Battery Type string */
-	batt_str = (char *)host_get_memmap(EC_MEMMAP_BATT_TYPE);
-	rv |= battery_device_chemistry(batt_str, EC_MEMMAP_TEXT_MAX);
+	rv |= battery_device_chemistry(info.type, EC_MEMMAP_TEXT_MAX);
+
+	host_memmap_update_begin();
+
+	memcpy(host_get_memmap(EC_MEMMAP_BATT_DCAP), &info, sizeof(info));
 
 	/* Zero the dynamic entries. They'll come next. */
 	*(int *)host_get_memmap(EC_MEMMAP_BATT_VOLT) = 0;
@@ -167,11 +185,14 @@ static int update_static_battery_info(void)
 	*(int *)host_get_memmap(EC_MEMMAP_BATT_LFCC) = 0;
 	*host_get_memmap(EC_MEMMAP_BATT_FLAG) = 0;
 
+	/* No errors seen. Battery data is now present */
+	if (!rv)
+		*host_get_memmap(EC_MEMMAP_BATTERY_VERSION) = 1;
+
+	host_memmap_update_end();
+
 	if (rv)
 		problem(PR_STATIC_UPDATE, rv);
-	else
-		/* No errors seen. Battery data is now present */
-		*host_get_memmap(EC_MEMMAP_BATTERY_VERSION) = 1;
 
 	return rv;
 }
@@ -184,6 +205,11 @@ static void update_dynamic_battery_info(void)
 	int *memmap_cap = (int *)host_get_memmap(EC_MEMMAP_BATT_CAP);
 	int *memmap_lfcc = (int *)host_get_memmap(EC_MEMMAP_BATT_LFCC);
 	uint8_t *memmap_flags = host_get_memmap(EC_MEMMAP_BATT_FLAG);
+	/* Work out the new values first, then copy them in one go */
+	int volt = *memmap_volt;
+	int rate = *memmap_rate;
+	int cap = *memmap_cap;
+	int lfcc = *memmap_lfcc;
 	uint8_t tmp;
 	int send_batt_status_event = 0;
 	int send_batt_info_event = 0;
@@ -212,10 +238,10 @@ static void update_dynamic_battery_info(void)
 	}
 
 	if (!(curr.batt.flags & BATT_FLAG_BAD_VOLTAGE))
-		*memmap_volt = curr.batt.voltage;
+		volt = curr.batt.voltage;
 
 	if (!(curr.batt.flags & BATT_FLAG_BAD_CURRENT))
-		*memmap_rate = ABS(curr.batt.current);
+		rate = ABS(curr.batt.current);
 
 	if (!(curr.batt.flags & BATT_FLAG_BAD_REMAINING_CAPACITY)) {
 		/*
@@ -224,15 +250,15 @@ static void update_dynamic_battery_info(void)
 		 * to Chrome OS powerd.
 		 */
 		if (curr.batt.remaining_capacity == 0 && !curr.batt_is_charging)
-			*memmap_cap = 1;
+			cap = 1;
 		else
-			*memmap_cap = curr.batt.remaining_capacity;
+			cap = curr.batt.remaining_capacity;
 	}
 
 	if (!(curr.batt.flags & BATT_FLAG_BAD_FULL_CAPACITY) &&
-	    (curr.batt.full_capacity <= (*memmap_lfcc - LFCC_EVENT_THRESH) ||
-	     curr.batt.full_capacity >= (*memmap_lfcc + LFCC_EVENT_THRESH))) {
-		*memmap_lfcc = curr.batt.full_capacity;
+	    (curr.batt.full_capacity <= (lfcc - LFCC_EVENT_THRESH) ||
+	     curr.batt.full_capacity >= (lfcc + LFCC_EVENT_THRESH))) {
+		lfcc = curr.batt.full_capacity;
 		/* Poke the AP if the full_capacity changes. */
 		send_batt_info_event++;
 	}
@@ -250,7 +276,13 @@ static void update_dynamic_battery_info(void)
 		send_batt_status_event++;
 
 	/* Update flags before sending host events. */
+	host_memmap_update_begin();
+	*memmap_volt = volt;
+	*memmap_rate = rate;
+	*memmap_cap = cap;
+	*memmap_lfcc = lfcc;
 	*memmap_flags = tmp;
+	host_memmap_update_end();
 
 	if (send_batt_info_event)
 		host_set_single_event(EC_HOST_EVENT_BATTERY);
@@ -7,6 +7,7 @@
 
 #include "clock.h"
 #include "console.h"
+#include "console_binlog.h"
 #include "link_defs.h"
 #include "system.h"
 #include "task.h"
@@ -105,6 +106,43 @@ static int split_words(char *input, int *argc, char **argv)
 	return EC_SUCCESS;
 }
 
+/**
+ * Find the first command whose name starts with a prefix, or sorts after it.
+ *
+ * The linker sorts the command table by name, so this is a binary search.
+ *
+ * @param prefix	Prefix to look for; need not be null-terminated.
+ * @param len		Length of prefix.
+ *
+ * @return A pointer into the command table; __cmds_end if every command sorts
+ *	before the prefix.
+ */
+static const struct console_command *find_first_command(const char *prefix,
+							int len)
+{
+	const struct console_command *lo = __cmds, *hi = __cmds_end;
+
+	while (lo < hi) {
+		const struct console_command *mid = lo + (hi - lo) / 2;
+
+		if (strncasecmp(prefix, mid->name, len) > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/**
+ * Check if a command name starts with a prefix.
+ */
+static int command_matches(const struct console_command *cmd,
+			   const char *prefix, int len)
+{
+	return cmd < __cmds_end && !strncasecmp(prefix, cmd->name, len);
+}
+
 /**
  * Find a command by name.
  *
@@ -118,26 +156,23 @@ static int split_words(char *input, int *argc, char **argv)
  */
 static const struct console_command *find_command(char *name)
 {
-	const struct console_command *cmd, *match = NULL;
 	int match_length = strlen(name);
+	const struct console_command *cmd =
+		find_first_command(name, match_length);
 
-	for (cmd = __cmds; cmd < __cmds_end; cmd++) {
-		if (!strncasecmp(name, cmd->name, match_length)) {
-			if (match)
-				return NULL;
-			/*
-			 * Check if 'cmd->name' is of the same length as
-			 * 'name'. If yes, then we have a full match.
-			 */
-			if (cmd->name[match_length] == '\0')
-				return cmd;
-			match = cmd;
-		}
-	}
+	if (!command_matches(cmd, name, match_length))
+		return NULL;
 
-	return match;
-}
+	/* A full match sorts before any longer names it's a prefix of */
+	if (cmd->name[match_length] == '\0')
+		return cmd;
 
+	/* Otherwise the partial match must be unique */
+	if (command_matches(cmd + 1, name, match_length))
+		return NULL;
+
+	return cmd;
+}
 
 static const char const *errmsgs[] = {
 	"OK",
@@ -319,6 +354,80 @@ static void handle_backspace(void)
 	input_pos--;
 }
 
+/**
+ * Insert a character at the cursor position.
+ */
+static void insert_char(int c)
+{
+	/* Ignore if line is full (leaving room for terminating null) */
+	if (input_len >= sizeof(input_buf) - 1)
+		return;
+
+	/* Print character */
+	console_putc(c);
+
+	/* If not at end of line, print rest of line and move it down */
+	if (input_pos != input_len) {
+		ccputs(input_buf + input_pos);
+		memmove(input_buf + input_pos + 1,
+			input_buf + input_pos,
+			input_len - input_pos + 1);
+		repeat_char('\b', input_len - input_pos);
+	}
+
+	/* Add character to buffer and terminate it */
+	input_buf[input_pos++] = c;
+	input_buf[++input_len] = '\0';
+}
+
+/**
+ * Complete the command name before the cursor.
+ *
+ * Adds as much of the name as all matching commands share.  If that's
+ * nothing, and the name is ambiguous, lists the matching commands.
+ */
+static void complete_command(void)
+{
+	const struct console_command *first, *last, *cmd;
+	int len = input_pos;
+	int i;
+
+	/* Only the command name is completed, not its arguments */
+	for (i = 0; i < len; i++) {
+		if (isspace(input_buf[i]))
+			return;
+	}
+
+	first = find_first_command(input_buf, len);
+	for (last = first; command_matches(last, input_buf, len); last++)
+		;
+	if (first == last)
+		return;
+
+	/*
+	 * The matches are sorted, so what they all share is what the first
+	 * and last share.
+	 */
+	for (i = len; first->name[i] &&
+		     tolower(first->name[i]) == tolower(last[-1].name[i]); i++)
+		insert_char(first->name[i]);
+
+	if (last - first == 1) {
+		if (input_buf[input_pos] != ' ')
+			insert_char(' ');
+	} else if (i == len) {
+		/* Five columns, like help */
+		for (cmd = first, i = 0; cmd < last; cmd++, i++) {
+			ccputs(i % 5 ? "" : "\n  ");
+			ccprintf("%-15s", cmd->name);
+			cflush();
+		}
+		ccputs("\n" PROMPT);
+		ccputs(input_buf);
+		repeat_char('\b', input_len - input_pos);
+	}
+}
+
 /**
  * Escape code handler
  *
@@ -512,30 +621,16 @@ static void console_handle_char(int c)
 
 #endif /* CONFIG_CONSOLE_HISTORY */
 
+	case '\t':
+		complete_command();
+		break;
+
 	default:
 		/* Ignore non-printing characters */
 		if (!isprint(c))
 			break;
 
-		/* Ignore if line is full (leaving room for terminating null) */
-		if (input_len >= sizeof(input_buf) - 1)
-			break;
-
-		/* Print character */
-		console_putc(c);
-
-		/* If not at end of line, print rest of line and move it down */
-		if (input_pos != input_len) {
-			ccputs(input_buf + input_pos);
-			memmove(input_buf + input_pos + 1,
-				input_buf + input_pos,
-				input_len - input_pos + 1);
-			repeat_char('\b', input_len - input_pos);
-		}
-
-		/* Add character to buffer and terminate it */
-		input_buf[input_pos++] = c;
-		input_buf[++input_len] = '\0';
+		insert_char(c);
 	}
 }
 
@@ -581,6 +676,11 @@ void console_task(void)
 			console_handle_char(c);
 		}
 
+#ifdef CONFIG_CONSOLE_BINLOG
+		/* Print deferred output before going back to sleep */
+		console_binlog_flush();
+#endif
+
 		task_wait_event(-1);  /* Wait for more input */
 	}
 }
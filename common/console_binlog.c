@@ -0,0 +1,629 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Binary console log; records console output to be formatted later */
+
+#include "common.h"
+#include "console.h"
+#include "console_binlog.h"
+#include "host_command.h"
+#include "printf.h"
+#include "task.h"
+#include "timer.h"
+#include "uart.h"
+#include "usb_console.h"
+#include "util.h"
+
+/* Longest string argument copied into a record, including the null */
+#define MAX_STRING 48
+
+/* Largest record, in words */
+#define MAX_RECORD_WORDS 32
+
+#define LOG_WORDS (CONFIG_CONSOLE_BINLOG_SIZE / sizeof(uint32_t))
+#define LOG_POS(offset) ((offset) & (LOG_WORDS - 1))
+BUILD_ASSERT(POWER_OF_TWO(LOG_WORDS));
+BUILD_ASSERT(LOG_WORDS >= 2 * MAX_RECORD_WORDS);
+
+static uint32_t log_buf[LOG_WORDS];
+
+/*
+ * Offsets count words since boot and are only wrapped when used, as in the PD
+ * event log.  A record never wraps around the end of the buffer; a zero header
+ * word pads out the end of the buffer instead.  All of these are only changed
+ * with interrupts disabled, since output can come from any task or interrupt.
+ */
+static uint32_t log_head;	/* End of the newest record */
+static uint32_t log_tail;	/* Start of the oldest record */
+static uint32_t log_print;	/* Next record for the console to print */
+static uint32_t log_dropped;	/* Records overwritten before printing */
+
+static enum console_binlog_mode binlog_mode = CONSOLE_BINLOG_DEFER;
+
+static struct mutex print_lock;
+
+/*
+ * Format strings are stored as offsets from this, so that they fit in a word
+ * even on a 64-bit host.
+ */
+static const char format_base[] = "";
+
+/* One field of a format string */
+struct field {
+	const char *spec;	/* '%' which starts the field */
+	const char *end;	/* Just past the conversion character */
+	int conv;		/* Conversion character */
+	int stars;		/* Number of '*' arguments */
+	int precision;		/* Literal precision, or 0 */
+	int precision_star;	/* Precision is the last '*' argument */
+	int is_64bit;		/* Integer is 64-bit */
+};
+
+/**
+ * Find the next field of a format string.
+ *
+ * This follows the parsing in vfnprintf().
+ *
+ * @param format	Pointer to the format string; advanced past the field
+ * @param f		Field description to fill in.  At the end of the
+ *			format string, spec points to the terminating null.
+ * @return The conversion character, or 0 at the end of the format string.
+ */
+static int next_field(const char **format, struct field *f)
+{
+	const char *p = *format;
+
+	memset(f, 0, sizeof(*f));
+
+	while (*p && *p != '%')
+		p++;
+	f->spec = p;
+	if (!*p) {
+		*format = p;
+		return 0;
+	}
+
+	p++;
+	if (*p == '%' || *p == '\0') {
+		f->conv = '%';
+		f->end = *p ? p + 1 : p;
+		*format = f->end;
+		return f->conv;
+	}
+
+	if (*p != 'c') {
+		if (*p == '-')
+			p++;
+		if (*p == '0')
+			p++;
+		if (*p == '*') {
+			f->stars++;
+			p++;
+		} else {
+			while (*p >= '0' && *p <= '9')
+				p++;
+		}
+		if (*p == '.') {
+			p++;
+			if (*p == '*') {
+				f->stars++;
+				f->precision_star = 1;
+				p++;
+			} else {
+				while (*p >= '0' && *p <= '9')
+					f->precision = 10 * f->precision +
+						*p++ - '0';
+			}
+		}
+		if (*p == 'l') {
+			f->is_64bit = 1;
+			p++;
+		}
+	}
+
+	/* A missing conversion character is left for vfnprintf() to reject */
+	f->conv = *p ? *p : '?';
+	f->end = *p ? p + 1 : p;
+	*format = f->end;
+	return f->conv;
+}
+
+/**
+ * Store the arguments for a format string.
+ *
+ * @param format	Format string
+ * @param args		Parameters
+ * @param out		Where to store the argument words, or NULL to just
+ *			count them
+ * @return The number of argument words, or -1 if they don't fit in a record.
+ */
+static int record_args(const char *format, va_list args, uint32_t *out)
+{
+	struct field f;
+	const char *s;
+	uint64_t v;
+	int words = 0;
+	int precision;
+	int limit;
+	int size;
+	int len;
+	int i;
+
+	while (next_field(&format, &f)) {
+		precision = f.precision;
+		for (i = 0; i < f.stars; i++) {
+			precision = va_arg(args, int);
+			if (out)
+				out[words] = precision;
+			words++;
+		}
+		if (!f.precision_star)
+			precision = f.precision;
+
+		switch (f.conv) {
+		case '%':
+		case 'T':
+			break;
+		case 'c':
+		case 'd':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'p':
+		case 'b':
+			if (f.is_64bit) {
+				v = va_arg(args, uint64_t);
+				if (out) {
+					out[words] = v;
+					out[words + 1] = v >> 32;
+				}
+				words += 2;
+			} else {
+				v = va_arg(args, uint32_t);
+				if (out)
+					out[words] = v;
+				words++;
+			}
+			break;
+		case 's':
+		case 'h':
+			s = va_arg(args, const char *);
+			if (f.conv == 's') {
+				if (!s)
+					s = "(NULL)";
+				/* Only as much as will be printed */
+				limit = MAX_STRING;
+				if (precision > 0 && precision < limit)
+					limit = precision;
+				for (len = 0; len < limit && s[len]; len++)
+					;
+				if (len == MAX_STRING)
+					return -1;
+			} else {
+				len = precision;
+				if (len > MAX_STRING)
+					return -1;
+			}
+			/* Strings keep their terminating null */
+			size = len + (f.conv == 's');
+			if (out) {
+				out[words] = size;
+				/* Clear the padding in the last word */
+				if (size)
+					out[words + (size + 3) / 4] = 0;
+				memcpy(out + words + 1, s, len);
+			}
+			words += 1 + DIV_ROUND_UP(size, sizeof(uint32_t));
+			break;
+		default:
+			/* Bad conversion; vfnprintf() stops printing here */
+			return words;
+		}
+
+		if (words > MAX_RECORD_WORDS - EC_BINLOG_HEADER_WORDS)
+			return -1;
+	}
+
+	return words;
+}
+
+/**
+ * Make room for this many words at the head of the log.
+ */
+static void log_make_room(int words)
+{
+	int size;
+
+	while (log_head + words - log_tail > LOG_WORDS) {
+		size = EC_BINLOG_SIZE(log_buf[LOG_POS(log_tail)]);
+		if (!size)
+			size = LOG_WORDS - LOG_POS(log_tail);
+		else if (log_print == log_tail)
+			log_dropped++;
+
+		if (log_print == log_tail)
+			log_print += size;
+		log_tail += size;
+	}
+}
+
+/**
+ * Reserve space for a record at the head of the log.
+ *
+ * Must be called with interrupts disabled.
+ *
+ * @param words		Size of the record
+ * @return Where to write the record.
+ */
+static uint32_t *log_reserve(int words)
+{
+	int pos = LOG_POS(log_head);
+
+	if (pos + words > LOG_WORDS) {
+		log_make_room(LOG_WORDS - pos);
+		log_buf[pos] = 0;
+		log_head += LOG_WORDS - pos;
+		pos = 0;
+	}
+	log_make_room(words);
+
+	return log_buf + pos;
+}
+
+/**
+ * Get ready for the caller to print output directly.
+ *
+ * Records still waiting for the console task are printed first, so the
+ * console shows output in the order it was made.  That can't be done from an
+ * interrupt, so output printed directly from one may still come out early.
+ *
+ * @return 0, so the caller prints the output.
+ */
+static int leave_to_caller(void)
+{
+	if (binlog_mode == CONSOLE_BINLOG_DEFER && !in_interrupt_context())
+		console_binlog_flush();
+
+	return 0;
+}
+
+int console_binlog_vprintf(enum console_channel channel, int flags,
+			   const char *format, va_list args)
+{
+	timestamp_t now;
+	va_list sizing;
+	uint32_t *r;
+	int words;
+
+	if (binlog_mode == CONSOLE_BINLOG_OFF)
+		return 0;
+
+	if (channel == CC_COMMAND)
+		return leave_to_caller();
+
+	va_copy(sizing, args);
+	words = record_args(format, sizing, NULL);
+	va_end(sizing);
+	if (words < 0)
+		return leave_to_caller();
+	words += EC_BINLOG_HEADER_WORDS;
+
+	now = get_time();
+
+	interrupt_disable();
+	r = log_reserve(words);
+	r[0] = EC_BINLOG_HEADER(words, channel, flags);
+	r[1] = format - format_base;
+	r[2] = now.le.lo;
+	r[3] = now.le.hi;
+	record_args(format, args, r + EC_BINLOG_HEADER_WORDS);
+	log_head += words;
+	if (binlog_mode != CONSOLE_BINLOG_DEFER)
+		log_print = log_head;
+	interrupt_enable();
+
+	if (binlog_mode == CONSOLE_BINLOG_DEFER && task_start_called())
+		task_wake(TASK_ID_CONSOLE);
+
+	return 1;
+}
+
+static int binlog_printf(enum console_channel channel, int flags,
+			 const char *format, ...)
+{
+	va_list args;
+	int rv;
+
+	va_start(args, format);
+	rv = console_binlog_vprintf(channel, flags, format, args);
+	va_end(args);
+
+	return rv;
+}
+
+int console_binlog_puts(enum console_channel channel, const char *outstr)
+{
+	return binlog_printf(channel, 0, "%s", outstr);
+}
+
+/**
+ * Format a single field, like vfnprintf_str().
+ */
+static int format_field(int (*addstr)(void *context, const char *str,
+				      int len),
+			void *context, const char *format, ...)
+{
+	va_list args;
+	int rv;
+
+	va_start(args, format);
+	rv = vfnprintf_str(addstr, context, format, args);
+	va_end(args);
+
+	return rv;
+}
+
+int console_binlog_format(const uint32_t *record,
+			  int (*addstr)(void *context, const char *str,
+					int len),
+			  void *context)
+{
+	const uint32_t *arg = record + EC_BINLOG_HEADER_WORDS;
+	const char *format = format_base + (int32_t)record[1];
+	uint64_t time = record[2] | ((uint64_t)record[3] << 32);
+	const char *run, *c;
+	struct field f;
+	char spec[24];
+	char *p;
+	int copy;
+	int rv;
+
+	if (record[0] & EC_BINLOG_FLAG_TIMESTAMP) {
+		rv = format_field(addstr, context, "[%.6ld ", time);
+		if (rv)
+			return rv;
+	}
+
+	while (1) {
+		run = format;
+		next_field(&format, &f);
+		if (f.spec > run && addstr(context, run, f.spec - run))
+			return EC_ERROR_OVERFLOW;
+		if (!f.conv)
+			break;
+
+		if (f.conv == '%') {
+			if (addstr(context, "%", 1))
+				return EC_ERROR_OVERFLOW;
+			continue;
+		}
+
+		/*
+		 * Rebuild the field with the '*' arguments filled in.  %T and
+		 * %h take their precision from the record instead.
+		 */
+		p = spec;
+		copy = 1;
+		for (c = f.spec; c < f.end - 1; c++) {
+			if ((f.conv == 'T' || f.conv == 'h') &&
+			    (*c == '.' || *c == 'l'))
+				copy = 0;
+			if (!copy && *c != '*')
+				continue;
+			if (p >= spec + sizeof(spec) - 16)
+				break;
+			if (*c != '*') {
+				*p++ = *c;
+			} else if (copy) {
+				snprintf(p, spec + sizeof(spec) - p, "%d",
+					 (int)*arg++);
+				p += strlen(p);
+			} else {
+				arg++;
+			}
+		}
+		if (f.conv == 'T') {
+			strzcpy(p, ".6ld", spec + sizeof(spec) - p);
+		} else if (f.conv == 'h') {
+			snprintf(p, spec + sizeof(spec) - p, ".%dh", (int)*arg);
+		} else {
+			*p++ = f.conv;
+			*p = '\0';
+		}
+
+		switch (f.conv) {
+		case 'T':
+			rv = format_field(addstr, context, spec, time);
+			break;
+		case 's':
+		case 'h':
+			rv = format_field(addstr, context, spec,
+					  (const char *)(arg + 1));
+			arg += 1 + DIV_ROUND_UP(*arg, sizeof(uint32_t));
+			break;
+		case 'c':
+		case 'd':
+		case 'u':
+		case 'x':
+		case 'X':
+		case 'p':
+		case 'b':
+			if (f.is_64bit) {
+				rv = format_field(addstr, context, spec,
+						  arg[0] |
+						  ((uint64_t)arg[1] << 32));
+				arg += 2;
+			} else {
+				rv = format_field(addstr, context, spec,
+						  *arg++);
+			}
+			break;
+		default:
+			/* Let vfnprintf() report the bad field, and stop */
+			return format_field(addstr, context, spec, 0);
+		}
+		if (rv)
+			return rv;
+	}
+
+	if ((record[0] & EC_BINLOG_FLAG_TIMESTAMP) && addstr(context, "]\n", 2))
+		return EC_ERROR_OVERFLOW;
+
+	return EC_SUCCESS;
+}
+
+/**
+ * Print to the console outputs, bypassing the log.
+ */
+static int print_direct(const char *format, ...)
+{
+	int rv1, rv2;
+	va_list args;
+
+	usb_va_start(args, format);
+	rv1 = usb_vprintf(format, args);
+	usb_va_end(args);
+
+	va_start(args, format);
+	rv2 = uart_vprintf(format, args);
+	va_end(args);
+
+	return rv1 == EC_SUCCESS ? rv2 : rv1;
+}
+
+static int print_str(void *context, const char *str, int len)
+{
+	/* Zero precision would print the whole string */
+	if (!len)
+		return 0;
+
+	return print_direct("%.*s", len, str);
+}
+
+void console_binlog_flush(void)
+{
+	/* Copy of the record being printed; protected by print_lock */
+	static uint32_t record[MAX_RECORD_WORDS];
+	uint32_t dropped;
+	int size;
+
+	mutex_lock(&print_lock);
+
+	while (1) {
+		interrupt_disable();
+		while (log_print != log_head &&
+		       !EC_BINLOG_SIZE(log_buf[LOG_POS(log_print)]))
+			log_print += LOG_WORDS - LOG_POS(log_print);
+		if (log_print == log_head) {
+			interrupt_enable();
+			break;
+		}
+		size = EC_BINLOG_SIZE(log_buf[LOG_POS(log_print)]);
+		memcpy(record, log_buf + LOG_POS(log_print),
+		       size * sizeof(uint32_t));
+		log_print += size;
+		dropped = log_dropped;
+		log_dropped = 0;
+		interrupt_enable();
+
+		if (dropped)
+			print_direct("[binlog: %d records dropped]\n", dropped);
+		console_binlog_format(record, print_str, NULL);
+	}
+
+	mutex_unlock(&print_lock);
+}
+
+void console_binlog_set_mode(enum console_binlog_mode mode)
+{
+	/* Print anything pending before it's forgotten */
+	console_binlog_flush();
+
+	interrupt_disable();
+	binlog_mode = mode;
+	log_print = log_head;
+	log_dropped = 0;
+	interrupt_enable();
+}
+
+/*****************************************************************************/
+/* Console commands */
+
+static int command_binlog(int argc, char **argv)
+{
+	static const char * const mode_names[] = {"off", "defer", "host"};
+	int i;
+
+	if (argc > 1) {
+		for (i = 0; i < ARRAY_SIZE(mode_names); i++) {
+			if (!strcasecmp(argv[1], mode_names[i]))
+				break;
+		}
+		if (i == ARRAY_SIZE(mode_names))
+			return EC_ERROR_PARAM1;
+		console_binlog_set_mode(i);
+	}
+
+	ccprintf("Mode:    %s\n", mode_names[binlog_mode]);
+	ccprintf("Offsets: %d - %d of %d words\n", log_tail, log_head,
+		 LOG_WORDS);
+
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(binlog, command_binlog,
+			"[off | defer | host]",
+			"Get/set the binary console log mode",
+			NULL);
+
+/*****************************************************************************/
+/* Host commands */
+
+static int console_binlog_read(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_console_binlog_read *p = args->params;
+	struct ec_response_console_binlog_read *r = args->response;
+	uint32_t offset = p->offset;
+	int words = 0;
+	int space;
+	int size;
+
+	if (args->response_max < sizeof(*r))
+		return EC_RES_INVALID_PARAM;
+	space = (args->response_max - sizeof(*r)) / sizeof(uint32_t);
+
+	interrupt_disable();
+
+	/* Records before the tail have been overwritten */
+	if ((int32_t)(offset - log_tail) < 0 ||
+	    (int32_t)(log_head - offset) < 0)
+		offset = log_tail;
+
+	while (offset != log_head) {
+		size = EC_BINLOG_SIZE(log_buf[LOG_POS(offset)]);
+		if (!size) {
+			offset += LOG_WORDS - LOG_POS(offset);
+			continue;
+		}
+		if (words + size > space)
+			break;
+		memcpy(r->data + words, log_buf + LOG_POS(offset),
+		       size * sizeof(uint32_t));
+		words += size;
+		offset += size;
+	}
+
+	r->next = offset;
+	r->head = log_head;
+
+	interrupt_enable();
+
+	r->format_base = (uintptr_t)format_base;
+	args->response_size = sizeof(*r) + words * sizeof(uint32_t);
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_CONSOLE_BINLOG_READ,
+		     console_binlog_read,
+		     EC_VER_MASK(0));
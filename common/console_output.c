@@ -6,6 +6,7 @@
 /* Console output module for Chrome EC */
 
 #include "console.h"
+#include "console_binlog.h"
 #include "uart.h"
 #include "usb_console.h"
 #include "util.h"
@@ -79,6 +80,23 @@ BUILD_ASSERT(CC_CHANNEL_COUNT <= 8*sizeof(uint32_t));
 /*****************************************************************************/
 /* Channel-based console output */
 
+/* Print to the USB console and UART, bypassing the binary log */
+static int print_direct(const char *format, ...)
+{
+	int rv1, rv2;
+	va_list args;
+
+	usb_va_start(args, format);
+	rv1 = usb_vprintf(format, args);
+	usb_va_end(args);
+
+	va_start(args, format);
+	rv2 = uart_vprintf(format, args);
+	va_end(args);
+
+	return rv1 == EC_SUCCESS ? rv2 : rv1;
+}
+
 int cputs(enum console_channel channel, const char *outstr)
 {
 	int rv1, rv2;
@@ -87,6 +105,11 @@ int cputs(enum console_channel channel, const char *outstr)
 	if (!(CC_MASK(channel) & channel_mask))
 		return EC_SUCCESS;
 
+#ifdef CONFIG_CONSOLE_BINLOG
+	if (console_binlog_puts(channel, outstr))
+		return EC_SUCCESS;
+#endif
+
 	rv1 = usb_puts(outstr);
 	rv2 = uart_puts(outstr);
 
@@ -102,6 +125,14 @@ int cprintf(enum console_channel channel, const char *format, ...)
 	if (!(CC_MASK(channel) & channel_mask))
 		return EC_SUCCESS;
 
+#ifdef CONFIG_CONSOLE_BINLOG
+	va_start(args, format);
+	rv1 = console_binlog_vprintf(channel, 0, format, args);
+	va_end(args);
+	if (rv1)
+		return EC_SUCCESS;
+#endif
+
 	usb_va_start(args, format);
 	rv1 = usb_vprintf(format, args);
 	usb_va_end(args);
@@ -122,7 +153,17 @@ int cprints(enum console_channel channel, const char *format, ...)
 	if (!(CC_MASK(channel) & channel_mask))
 		return EC_SUCCESS;
 
-	rv = cprintf(channel, "[%T ");
+#ifdef CONFIG_CONSOLE_BINLOG
+	va_start(args, format);
+	r = console_binlog_vprintf(channel, EC_BINLOG_FLAG_TIMESTAMP, format,
+				   args);
+	va_end(args);
+	if (r)
+		return EC_SUCCESS;
+#endif
+
+	/* The whole line is printed directly, not just the middle of it */
+	rv = print_direct("[%T ");
 
 	va_start(args, format);
 	r = uart_vprintf(format, args);
@@ -136,7 +177,7 @@ int cprints(enum console_channel channel, const char *format, ...)
 		rv = r;
 	usb_va_end(args);
 
-	r = cputs(channel, "]\n");
+	r = print_direct("]\n");
 	return r ? r : rv;
 }
 
@@ -475,6 +475,7 @@ static void pwm_fan_second(void)
 	int stalled = 0;
 	int fan;
 
+	host_memmap_update_begin();
 	for (fan = 0; fan < CONFIG_FANS; fan++) {
 		if (fan_is_stalled(fans[fan].ch)) {
 			rpm = EC_FAN_SPEED_STALLED;
@@ -486,6 +487,7 @@ static void pwm_fan_second(void)
 
 		mapped[fan] = rpm;
 	}
+	host_memmap_update_end();
 
 	/*
 	 * Issue warning.  As we have thermal shutdown
@@ -590,6 +590,10 @@ static int command_flash_erase(int argc, char **argv)
 	if (flash_get_protect() & EC_FLASH_PROTECT_ALL_NOW)
 		return EC_ERROR_ACCESS_DENIED;
 
+	/* Don't erase under a background erase */
+	if (host_command_async_pending())
+		return EC_ERROR_BUSY;
+
 	rv = parse_offset_size(argc, argv, 1, &offset, &size);
 	if (rv)
 		return rv;
@@ -613,6 +617,10 @@ static int command_flash_write(int argc, char **argv)
 	if (flash_get_protect() & EC_FLASH_PROTECT_ALL_NOW)
 		return EC_ERROR_ACCESS_DENIED;
 
+	/* Don't write under a background erase */
+	if (host_command_async_pending())
+		return EC_ERROR_BUSY;
+
 	rv = parse_offset_size(argc, argv, 1, &offset, &size);
 	if (rv)
 		return rv;
@@ -796,6 +804,10 @@ static int flash_command_write(struct host_cmd_handler_args *args)
 {
 	const struct ec_params_flash_write *p = args->params;
 
+	/* Flash is still being erased in the background */
+	if (host_command_async_pending())
+		return EC_RES_BUSY;
+
 	if (flash_get_protect() & EC_FLASH_PROTECT_ALL_NOW)
 		return EC_RES_ACCESS_DENIED;
 
@@ -814,25 +826,50 @@ DECLARE_HOST_COMMAND(EC_CMD_FLASH_WRITE,
 		     flash_command_write,
 		     EC_VER_MASK(0) | EC_VER_MASK(EC_VER_FLASH_WRITE));
 
+/* Bytes of the erase in progress done so far */
+static int erase_done;
+
+static int flash_erase_routine(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_flash_erase *p = args->params;
+	int rv = EC_RES_SUCCESS;
+
+	/* Erase a block per call, so the hook task isn't held up for long */
+	if (erase_done < p->size) {
+		if (flash_erase(p->offset + erase_done,
+				CONFIG_FLASH_ERASE_SIZE))
+			rv = EC_RES_ERROR;
+		else
+			erase_done += CONFIG_FLASH_ERASE_SIZE;
+	}
+
+	if (rv == EC_RES_SUCCESS && erase_done < p->size)
+		return EC_RES_IN_PROGRESS;
+
+	erase_done = 0;
+	return rv;
+}
+
 static int flash_command_erase(struct host_cmd_handler_args *args)
 {
 	const struct ec_params_flash_erase *p = args->params;
 
+	/* Flash is still being erased in the background */
+	if (host_command_async_pending())
+		return EC_RES_BUSY;
+
 	if (flash_get_protect() & EC_FLASH_PROTECT_ALL_NOW)
 		return EC_RES_ACCESS_DENIED;
 
 	if (system_unsafe_to_overwrite(p->offset, p->size))
 		return EC_RES_ACCESS_DENIED;
 
-	/* Indicate that we might be a while */
-#if defined(HAS_TASK_HOSTCMD) && defined(CONFIG_HOST_COMMAND_STATUS)
-	args->result = EC_RES_IN_PROGRESS;
-	host_send_response(args);
-#endif
-	if (flash_erase(p->offset, p->size))
+	/* Check the whole range before erasing any of it */
+	if (!flash_range_ok(p->offset, p->size, CONFIG_FLASH_ERASE_SIZE))
 		return EC_RES_ERROR;
 
-	return EC_RES_SUCCESS;
+	/* Erasing can take a while, so don't hold up other commands */
+	return host_command_async(args, flash_erase_routine);
 }
 DECLARE_HOST_COMMAND(EC_CMD_FLASH_ERASE,
 		     flash_command_erase,
@@ -843,6 +880,10 @@ static int flash_command_protect(struct host_cmd_handler_args *args)
 	const struct ec_params_flash_protect *p = args->params;
 	struct ec_response_flash_protect *r = args->response;
 
+	/* Flash is still being erased in the background */
+	if (host_command_async_pending())
+		return EC_RES_BUSY;
+
 	/*
 	 * Handle requesting new flags.  Note that we ignore the return code
 	 * from flash_set_protect(), since errors will be visible to the caller
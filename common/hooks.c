@@ -20,8 +20,6 @@
 #define CPRINTS(format, args...)
 #endif
 
-#define DEFERRED_FUNCS_COUNT (__deferred_funcs_end - __deferred_funcs)
-
 struct hook_ptrs {
 	const struct hook_data *start;
 	const struct hook_data *end;
@@ -50,11 +48,36 @@ static const struct hook_ptrs hook_list[] = {
 	{__hooks_second, __hooks_second_end},
 };
 
-/* Times for deferrable functions */
+/*
+ * Deferred calls are armed from any context by writing the requested time to
+ * defer_until[] and flagging the routine in defer_changed[].  Only the hook
+ * task applies those requests to defer_heap[], a min-heap of the pending
+ * routines ordered by deadline, so neither arming nor dispatch needs to look
+ * at every registered routine.
+ */
+#define DEFER_CHANGED_WORDS ((DEFERRABLE_MAX_COUNT + 31) / 32)
+
+BUILD_ASSERT(DEFERRABLE_MAX_COUNT < 0xff);
+
+/* Requested time for each deferrable function, or 0 to cancel */
 static uint64_t defer_until[DEFERRABLE_MAX_COUNT];
-static int defer_new_call;
+static uint32_t defer_changed[DEFER_CHANGED_WORDS];
+
+/* Owned by the hook task */
+static uint64_t defer_deadline[DEFERRABLE_MAX_COUNT];
+static uint8_t defer_heap_pos[DEFERRABLE_MAX_COUNT]; /* Index + 1, or 0 */
+static uint8_t defer_heap[DEFERRABLE_MAX_COUNT];
+static int defer_heap_size;
+
 static int hook_task_started;
 
+/*
+ * Order in which to call the hooks of each type, as indices into the type's
+ * table, sorted by priority.  Built once, on the first hook_notify(), in
+ * space the linker reserves after the hook tables.
+ */
+static int hook_order_ready;
+
 #ifdef CONFIG_HOOK_DEBUG
 /* Stats for hooks */
 static uint64_t max_hook_tick_delay;
@@ -89,38 +112,84 @@ static void record_hook_delay(uint64_t now, uint64_t last, uint64_t interval,
 }
 #endif
 
+static uint8_t *hook_order(enum hook_type type)
+{
+	return __hook_order + (hook_list[type].start - __hooks_init);
+}
+
+static void hook_sort(void)
+{
+	int type, i, j;
+
+	for (type = 0; type < ARRAY_SIZE(hook_list); type++) {
+		const struct hook_data *start = hook_list[type].start;
+		int count = hook_list[type].end - start;
+		uint8_t *order = hook_order(type);
+
+		/*
+		 * Insertion sort.  This is stable, so hooks of the same
+		 * priority are still called in link order.
+		 */
+		for (i = 0; i < count; i++) {
+			for (j = i; j > 0 &&
+			     start[order[j - 1]].priority > start[i].priority;
+			     j--)
+				order[j] = order[j - 1];
+			order[j] = i;
+		}
+	}
+
+	hook_order_ready = 1;
+}
+
+#ifdef CONFIG_HOOK_DEBUG
+static void record_routine_run_time(struct hook_stats *stats,
+				    uint32_t run_time)
+{
+	stats->last_run_time = run_time;
+	if (run_time > stats->max_run_time)
+		stats->max_run_time = run_time;
+	stats->avg_run_time = stats->calls ?
+		(stats->avg_run_time * 7 + run_time) >> 3 : run_time;
+	stats->calls++;
+}
+#endif
+
 void hook_notify(enum hook_type type)
 {
-	const struct hook_data *start, *end, *p;
-	int count, called = 0;
-	int last_prio = HOOK_PRIO_FIRST - 1, prio;
+	const struct hook_data *start, *p;
+	const uint8_t *order;
+	int count, i;
 #ifdef CONFIG_HOOK_DEBUG
 	uint64_t start_time = get_time().val;
+	uint64_t routine_start;
 	uint64_t run_time;
 #endif
 
 	CPRINTS("hook notify %d", type);
 
+	/*
+	 * The first call is HOOK_INIT at the latest, before the other tasks
+	 * are enabled, so this doesn't race with itself.
+	 */
+	if (!hook_order_ready)
+		hook_sort();
+
 	start = hook_list[type].start;
-	end = hook_list[type].end;
-	count = end - start;
+	count = hook_list[type].end - start;
+	order = hook_order(type);
 
 	/* Call all the hooks in priority order */
-	while (called < count) {
-		/* Find the lowest remaining priority */
-		for (p = start, prio = HOOK_PRIO_LAST + 1; p < end; p++) {
-			if (p->priority < prio && p->priority > last_prio)
-				prio = p->priority;
-		}
-		last_prio = prio;
-
-		/* Call all the hooks with that priority */
-		for (p = start; p < end; p++) {
-			if (p->priority == prio) {
-				called++;
-				p->routine();
-			}
-		}
+	for (i = 0; i < count; i++) {
+		p = start + order[i];
+#ifdef CONFIG_HOOK_DEBUG
+		routine_start = get_time().val;
+#endif
+		p->routine();
+#ifdef CONFIG_HOOK_DEBUG
+		record_routine_run_time(p->stats,
+					get_time().val - routine_start);
+#endif
 	}
 
 #ifdef CONFIG_HOOK_DEBUG
@@ -131,20 +200,137 @@ void hook_notify(enum hook_type type)
 #endif
 }
 
-int hook_call_deferred(void (*routine)(void), int us)
+static inline int defer_heap_before(int a, int b)
 {
-	const struct deferred_data *p;
-	int i;
+	return defer_deadline[defer_heap[a]] < defer_deadline[defer_heap[b]];
+}
 
-	/* Find the index of the routine */
-	for (p = __deferred_funcs; p < __deferred_funcs_end; p++) {
-		if (p->routine == routine)
+static void defer_heap_swap(int a, int b)
+{
+	uint8_t t = defer_heap[a];
+
+	defer_heap[a] = defer_heap[b];
+	defer_heap[b] = t;
+	defer_heap_pos[defer_heap[a]] = a + 1;
+	defer_heap_pos[defer_heap[b]] = b + 1;
+}
+
+/* Restore heap order for the entry at index i, moving it up or down. */
+static void defer_heap_fix(int i)
+{
+	int child;
+
+	while (i > 0 && defer_heap_before(i, (i - 1) / 2)) {
+		defer_heap_swap(i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+
+	while ((child = 2 * i + 1) < defer_heap_size) {
+		if (child + 1 < defer_heap_size &&
+		    defer_heap_before(child + 1, child))
+			child++;
+		if (!defer_heap_before(child, i))
 			break;
+		defer_heap_swap(i, child);
+		i = child;
 	}
-	if (p >= __deferred_funcs_end)
-		return EC_ERROR_INVAL;  /* Routine not registered */
+}
+
+static void defer_heap_remove(int idx)
+{
+	int i = defer_heap_pos[idx] - 1;
+
+	if (i < 0)
+		return;
+
+	defer_heap_pos[idx] = 0;
+	if (i == --defer_heap_size)
+		return;
+
+	defer_heap[i] = defer_heap[defer_heap_size];
+	defer_heap_pos[defer_heap[i]] = i + 1;
+	defer_heap_fix(i);
+}
 
-	i = p - __deferred_funcs;
+static void defer_heap_update(int idx, uint64_t deadline)
+{
+	int i = defer_heap_pos[idx] - 1;
+
+	if (i < 0) {
+		i = defer_heap_size++;
+		defer_heap[i] = idx;
+		defer_heap_pos[idx] = i + 1;
+	}
+	defer_deadline[idx] = deadline;
+	defer_heap_fix(i);
+}
+
+/*
+ * Move the requests made since the last call into the heap.  Must be called
+ * with interrupts disabled, so a request can't be torn or lost while it is
+ * being read.
+ */
+static void defer_apply_changes(void)
+{
+	int w;
+
+	for (w = 0; w < DEFER_CHANGED_WORDS; w++) {
+		uint32_t changed = defer_changed[w];
+
+		defer_changed[w] = 0;
+		while (changed) {
+			int idx = w * 32 + __builtin_ctz(changed);
+
+			changed &= changed - 1;
+			if (defer_until[idx])
+				defer_heap_update(idx, defer_until[idx]);
+			else
+				defer_heap_remove(idx);
+		}
+	}
+}
+
+static int defer_changes_pending(void)
+{
+	int w;
+
+	for (w = 0; w < DEFER_CHANGED_WORDS; w++) {
+		if (defer_changed[w])
+			return 1;
+	}
+	return 0;
+}
+
+/*
+ * Return the index of the earliest deferred routine due by the given time
+ * and clear its request, or -1 if none is due.
+ */
+static int defer_pop_due(uint64_t t)
+{
+	int idx = -1;
+
+	interrupt_disable();
+	defer_apply_changes();
+	if (defer_heap_size && defer_deadline[defer_heap[0]] <= t) {
+		idx = defer_heap[0];
+		defer_heap_remove(idx);
+		/*
+		 * Clear timer before the call, so the routine can request
+		 * itself be called later.
+		 */
+		defer_until[idx] = 0;
+	}
+	interrupt_enable();
+
+	return idx;
+}
+
+int hook_call_deferred_data(const struct deferred_data *data, int us)
+{
+	int i = data - __deferred_funcs;
+
+	if (data < __deferred_funcs || data >= __deferred_funcs_end)
+		return EC_ERROR_INVAL;  /* Routine not registered */
 
 	if (us == -1) {
 		/* Cancel */
@@ -152,21 +338,35 @@ int hook_call_deferred(void (*routine)(void), int us)
 	} else {
 		/* Set alarm */
 		defer_until[i] = get_time().val + us;
-		/*
-		 * Flag that hook_call_deferred() has been called.  If the hook
-		 * task is already active, this will allow it to go through the
-		 * loop one more time before sleeping.
-		 */
-		defer_new_call = 1;
-
-		/* Wake task so it can re-sleep for the proper time */
-		if (hook_task_started)
-			task_wake(TASK_ID_HOOKS);
 	}
 
+	/*
+	 * Flag the request for the hook task.  If the hook task is already
+	 * active, this will make it go through the loop one more time before
+	 * sleeping.
+	 */
+	atomic_or(&defer_changed[i / 32], 1 << (i % 32));
+
+	/* Wake task so it can re-sleep for the proper time */
+	if (us != -1 && hook_task_started)
+		task_wake(TASK_ID_HOOKS);
+
 	return EC_SUCCESS;
 }
 
+int hook_call_deferred(void (*routine)(void), int us)
+{
+	const struct deferred_data *p;
+
+	/* Find the routine */
+	for (p = __deferred_funcs; p < __deferred_funcs_end; p++) {
+		if (p->routine == routine)
+			return hook_call_deferred_data(p, us);
+	}
+
+	return EC_ERROR_INVAL;  /* Routine not registered */
+}
+
 void hook_task(void)
 {
 	/* Periodic hooks will be called first time through the loop */
@@ -186,18 +386,11 @@ void hook_task(void)
 		int next = 0;
 		int i;
 
-		/* Handle deferred routines */
-		for (i = 0; i < DEFERRED_FUNCS_COUNT; i++) {
-			if (defer_until[i] && defer_until[i] < t) {
-				CPRINTS("hook call deferred 0x%p",
-					__deferred_funcs[i].routine);
-				/*
-				 * Call deferred function.  Clear timer first,
-				 * so it can request itself be called later.
-				 */
-				defer_until[i] = 0;
-				__deferred_funcs[i].routine();
-			}
+		/* Handle deferred routines, earliest first */
+		while ((i = defer_pop_due(t)) >= 0) {
+			CPRINTS("hook call deferred 0x%p",
+				__deferred_funcs[i].routine);
+			__deferred_funcs[i].routine();
 		}
 
 		if (t - last_tick >= HOOK_TICK_INTERVAL) {
@@ -226,15 +419,16 @@ void hook_task(void)
 			next = last_tick + HOOK_TICK_INTERVAL - t;
 
 		/* Wake earlier if needed by a deferred routine */
-		defer_new_call = 0;
-		for (i = 0; i < DEFERRED_FUNCS_COUNT && next > 0; i++) {
-			if (!defer_until[i])
-				continue;
+		interrupt_disable();
+		defer_apply_changes();
+		interrupt_enable();
+		if (defer_heap_size && next > 0) {
+			uint64_t deadline = defer_deadline[defer_heap[0]];
 
-			if (defer_until[i] < t)
+			if (deadline < t)
 				next = 0;
-			else if (defer_until[i] - t < next)
-				next = defer_until[i] - t;
+			else if (deadline - t < next)
+				next = deadline - t;
 		}
 
 		/*
@@ -242,7 +436,7 @@ void hook_task(void)
 		 * hasn't been called since we started calculating next, sleep
 		 * until the next event.
 		 */
-		if (next > 0 && !defer_new_call)
+		if (next > 0 && !defer_changes_pending())
 			task_wait_event(next);
 	}
 }
@@ -261,10 +455,42 @@ static void print_hook_delay(uint32_t interval, uint32_t delay, uint32_t avg)
 	ccprintf("  Average:     %7d us (%d%%)\n\n", avg, percent_avg);
 }
 
+static void print_routine_stats(enum hook_type type)
+{
+	const struct hook_data *start = hook_list[type].start;
+	int count = hook_list[type].end - start;
+	const uint8_t *order = hook_order(type);
+	int i;
+
+	ccprintf("Prio  Routine        Last     Max     Avg   Calls (us)\n");
+	for (i = 0; i < count; i++) {
+		const struct hook_data *p = start + order[i];
+
+		ccprintf("%4d  0x%p %7d %7d %7d %7d\n", p->priority,
+			 p->routine, p->stats->last_run_time,
+			 p->stats->max_run_time, p->stats->avg_run_time,
+			 p->stats->calls);
+		cflush();
+	}
+}
+
 static int command_stats(int argc, char **argv)
 {
 	int i;
 
+	if (argc > 1) {
+		char *e;
+
+		i = strtoi(argv[1], &e, 0);
+		if (*e || i < 0 || i >= ARRAY_SIZE(hook_list))
+			return EC_ERROR_PARAM1;
+
+		if (!hook_order_ready)
+			hook_sort();
+		print_routine_stats(i);
+		return EC_SUCCESS;
+	}
+
 	ccprintf("HOOK_TICK:\n");
 	print_hook_delay(HOOK_TICK_INTERVAL, max_hook_tick_delay,
 			 avg_hook_tick_delay);
@@ -281,7 +507,7 @@ static int command_stats(int argc, char **argv)
 	return EC_SUCCESS;
 }
 DECLARE_CONSOLE_COMMAND(hookstats, command_stats,
-			NULL,
-			"Print stats of hooks",
+			"[type]",
+			"Print stats of hooks, or of each routine of one type",
 			NULL);
 #endif
@@ -8,6 +8,7 @@
 #include "ap_hang_detect.h"
 #include "common.h"
 #include "console.h"
+#include "hooks.h"
 #include "host_command.h"
 #include "link_defs.h"
 #include "lpc.h"
@@ -53,14 +54,27 @@ static const char * const hcdebug_mode_names[HCDEBUG_MODES] = {
 	"off", "normal", "every", "params"};
 
 #ifdef CONFIG_HOST_COMMAND_STATUS
+/* Size of the params and response buffers for background commands */
+#define ASYNC_BUF_SIZE 64
+
+/* Pause between the steps of a background command */
+#define ASYNC_STEP_DELAY_US MSEC
+
 /*
  * Indicates that a 'slow' command has sent EC_RES_IN_PROGRESS but hasn't
- * sent a final status (i.e. it is in progress)
+ * finished yet (i.e. it is in progress)
  */
-static uint8_t command_pending;
+static volatile uint8_t command_pending;
 
-/* The result of the last 'slow' operation */
+/* The result and response of the last 'slow' operation */
 static uint8_t saved_result = EC_RES_UNAVAILABLE;
+static int saved_response_size;
+
+/* The slow operation, and its own copy of the command */
+static int (*async_routine)(struct host_cmd_handler_args *args);
+static struct host_cmd_handler_args async_args;
+static uint8_t async_params[ASYNC_BUF_SIZE] __aligned(4);
+static uint8_t async_response[ASYNC_BUF_SIZE] __aligned(4);
 #endif
 
 /*
@@ -81,6 +95,29 @@ uint8_t *host_get_memmap(int offset)
 #endif
 }
 
+void host_memmap_update_begin(void)
+{
+	uint8_t *seq = host_get_memmap(EC_MEMMAP_UPDATE_SEQ);
+	uint8_t *busy = host_get_memmap(EC_MEMMAP_UPDATE_BUSY);
+
+	/* Mark busy before moving the sequence number; see ec_commands.h */
+	interrupt_disable();
+	(*busy)++;
+	(*seq)++;
+	interrupt_enable();
+}
+
+void host_memmap_update_end(void)
+{
+	uint8_t *seq = host_get_memmap(EC_MEMMAP_UPDATE_SEQ);
+	uint8_t *busy = host_get_memmap(EC_MEMMAP_UPDATE_BUSY);
+
+	interrupt_disable();
+	(*seq)++;
+	(*busy)--;
+	interrupt_enable();
+}
+
 int host_get_vboot_mode(void)
 {
 	return g_vboot_mode;
@@ -88,51 +125,13 @@ int host_get_vboot_mode(void)
 
 test_mockable void host_send_response(struct host_cmd_handler_args *args)
 {
-#ifdef CONFIG_HOST_COMMAND_STATUS
 	/*
-	 *
-	 * If we are in interrupt context, then we are handling a get_status
-	 * response or an immediate error which prevented us from processing
-	 * the command. Note we can't check for the GET_COMMS_STATUS command in
-	 * args->command because the original command value has now been
-	 * overwritten.
-	 *
-	 * When a EC_CMD_RESEND_RESPONSE arrives we will supply this response
-	 * to that command.
+	 * Batch sub-commands don't have responses of their own; the batch
+	 * responds once they're all done.
 	 */
-	if (!in_interrupt_context()) {
-		if (command_pending) {
-			/*
-			 * We previously got EC_RES_IN_PROGRESS.  This must be
-			 * the completion of that command, so stash the result
-			 * code.
-			 */
-			CPRINTS("HC pending done, size=%d, result=%d",
-				args->response_size, args->result);
-
-			/*
-			 * We don't support stashing response data, so mark the
-			 * response as unavailable in that case.
-			 */
-			if (args->response_size != 0)
-				saved_result = EC_RES_UNAVAILABLE;
-			else
-				saved_result = args->result;
-
-			/*
-			 * We can't send the response back to the host now
-			 * since we already sent the in-progress response and
-			 * the host is on to other things now.
-			 */
-			command_pending = 0;
-			return;
+	if (!args->send_response)
+		return;
 
-		} else if (args->result == EC_RES_IN_PROGRESS) {
-			command_pending = 1;
-			CPRINTS("HC pending");
-		}
-	}
-#endif
 	args->send_response(args);
 }
 
@@ -353,6 +352,47 @@ host_packet_bad:
 	host_packet_respond(&args0);
 }
 
+/*
+ * Hash index of the host command table.  Each slot holds the table index + 1
+ * of a command, or 0 if it's empty; commands which collide go in the next
+ * free slot.  Kept at most half full, so lookups stay short.
+ */
+#define HCMD_INDEX_SIZE 256
+static uint8_t hcmd_index[HCMD_INDEX_SIZE];
+static int hcmd_index_ready;
+
+static inline int hcmd_hash(int command)
+{
+	/* Multiplicative hash; the top bits depend on all the command bits */
+	return ((uint32_t)command * 0x9e3779b1) >> 24;
+}
+
+static void host_command_index_init(void)
+{
+	int count = __hcmds_end - __hcmds;
+	int i, slot;
+
+	if (count > HCMD_INDEX_SIZE / 2) {
+		CPRINTS("Too many host commands to index: %d", count);
+		return;
+	}
+
+	/*
+	 * Commands are added in table order, so if a command is declared
+	 * twice, the lookup finds the same one a table scan would.
+	 */
+	for (i = 0; i < count; i++) {
+		slot = hcmd_hash(__hcmds[i].command);
+		while (hcmd_index[slot])
+			slot = (slot + 1) % HCMD_INDEX_SIZE;
+		hcmd_index[slot] = i + 1;
+	}
+
+	hcmd_index_ready = 1;
+}
+/* Before any task can send host commands */
+DECLARE_HOOK(HOOK_INIT, host_command_index_init, HOOK_PRIO_FIRST);
+
 /**
  * Find a command by command number.
  *
@@ -362,8 +402,19 @@ host_packet_bad:
 static const struct host_command *find_host_command(int command)
 {
 	const struct host_command *cmd;
+	int slot;
 
-	for (cmd = __hcmds; cmd < __hcmds_end; cmd++) {
+	if (!hcmd_index_ready) {
+		for (cmd = __hcmds; cmd < __hcmds_end; cmd++) {
+			if (command == cmd->command)
+				return cmd;
+		}
+		return NULL;
+	}
+
+	for (slot = hcmd_hash(command); hcmd_index[slot];
+	     slot = (slot + 1) % HCMD_INDEX_SIZE) {
+		cmd = __hcmds + hcmd_index[slot] - 1;
 		if (command == cmd->command)
 			return cmd;
 	}
@@ -376,7 +427,7 @@ static void host_command_init(void)
 	/* Initialize memory map ID area */
 	host_get_memmap(EC_MEMMAP_ID)[0] = 'E';
 	host_get_memmap(EC_MEMMAP_ID)[1] = 'C';
-	*host_get_memmap(EC_MEMMAP_ID_VERSION) = 1;
+	*host_get_memmap(EC_MEMMAP_ID_VERSION) = 2;
 	*host_get_memmap(EC_MEMMAP_EVENTS_VERSION) = 1;
 
 #ifdef CONFIG_HOSTCMD_EVENTS
@@ -502,6 +553,59 @@ DECLARE_HOST_COMMAND(EC_CMD_READ_MEMMAP,
 		     EC_VER_MASK(0));
 #endif
 
+/* Times to try copying the memory map before giving up */
+#define MEMMAP_SNAPSHOT_TRIES 10
+
+static int host_command_memmap_snapshot(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_memmap_snapshot *p = args->params;
+	struct ec_response_memmap_snapshot *r = args->response;
+	volatile uint8_t *seq = host_get_memmap(EC_MEMMAP_UPDATE_SEQ);
+	volatile uint8_t *busy = host_get_memmap(EC_MEMMAP_UPDATE_BUSY);
+
+	/* Copy params out of data before we overwrite it with output */
+	uint8_t offset = p->offset;
+	uint8_t size = p->size;
+	uint8_t flags = p->flags;
+	uint8_t last_seq = p->seq;
+	uint8_t start;
+	int i;
+
+	if (offset + size > EC_MEMMAP_SIZE ||
+	    sizeof(*r) + size > args->response_max)
+		return EC_RES_INVALID_PARAM;
+
+	for (i = 0; i < MEMMAP_SNAPSHOT_TRIES; i++) {
+		if (i)
+			msleep(1);
+
+		start = *seq;
+		if (*busy)
+			continue;
+
+		r->seq = start;
+		r->reserved[0] = r->reserved[1] = 0;
+		if ((flags & EC_MEMMAP_SNAPSHOT_IF_CHANGED) &&
+		    start == last_seq) {
+			r->flags = EC_MEMMAP_SNAPSHOT_UNCHANGED;
+			args->response_size = sizeof(*r);
+			return EC_RES_SUCCESS;
+		}
+
+		r->flags = 0;
+		memcpy(r->data, host_get_memmap(offset), size);
+		if (*seq == start) {
+			args->response_size = sizeof(*r) + size;
+			return EC_RES_SUCCESS;
+		}
+	}
+
+	return EC_RES_BUSY;
+}
+DECLARE_HOST_COMMAND(EC_CMD_MEMMAP_SNAPSHOT,
+		     host_command_memmap_snapshot,
+		     EC_VER_MASK(0));
+
 static int host_command_get_cmd_versions(struct host_cmd_handler_args *args)
 {
 	const struct ec_params_get_cmd_versions *p = args->params;
@@ -525,6 +629,106 @@ DECLARE_HOST_COMMAND(EC_CMD_GET_CMD_VERSIONS,
 		     host_command_get_cmd_versions,
 		     EC_VER_MASK(0) | EC_VER_MASK(1));
 
+#ifdef CONFIG_HOSTCMD_BATCH
+static int host_command_batch(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_batch *p;
+	struct ec_response_batch *r = args->response;
+	struct host_cmd_handler_args sub;
+	const uint8_t *in, *in_end;
+	uint8_t *out, *out_end;
+	char *params;
+	void *scratch;
+	int i;
+
+	if (args->params_size < sizeof(*p) || args->response_max < sizeof(*r))
+		return EC_RES_INVALID_PARAM;
+
+	/*
+	 * Responses may overwrite the request, so work from a copy of it.
+	 * Handlers write their whole response whatever response_max is, so
+	 * each sub-command is run into a scratch buffer as big as the one a
+	 * standalone command gets, and only what fits is copied out.
+	 */
+	if (shared_mem_acquire(EC_BATCH_ALIGN(args->params_size) +
+			       args->response_max, &params))
+		return EC_RES_BUSY;
+	memcpy(params, args->params, args->params_size);
+	scratch = params + EC_BATCH_ALIGN(args->params_size);
+	p = (const struct ec_params_batch *)params;
+	in_end = (const uint8_t *)params + args->params_size;
+
+	/* Check the whole request before running any of it */
+	in = (const uint8_t *)(p + 1);
+	for (i = 0; i < p->count; i++) {
+		const struct ec_batch_request *req = (const void *)in;
+
+		int left = in_end - in;
+
+		if (left < (int)sizeof(*req) ||
+		    left < (int)sizeof(*req) + req->size) {
+			shared_mem_release(params);
+			return EC_RES_REQUEST_TRUNCATED;
+		}
+		in += sizeof(*req) + EC_BATCH_ALIGN(req->size);
+	}
+
+	in = (const uint8_t *)(p + 1);
+	out = (uint8_t *)(r + 1);
+	out_end = (uint8_t *)args->response + args->response_max;
+	for (i = 0; i < p->count; i++) {
+		const struct ec_batch_request *req = (const void *)in;
+		struct ec_batch_response *resp = (void *)out;
+		int rv;
+
+		/* Leave room for the padding, too */
+		if (out_end - out < (int)sizeof(*resp) +
+		    EC_BATCH_ALIGN(req->response_max))
+			break;
+
+		sub = *args;
+		sub.send_response = NULL;
+		sub.command = req->command;
+		sub.version = req->version;
+		sub.params = req + 1;
+		sub.params_size = req->size;
+		sub.response = scratch;
+		sub.response_max = args->response_max;
+		sub.response_size = 0;
+		sub.result = EC_RES_SUCCESS;
+
+		if (req->command == EC_CMD_BATCH)
+			rv = EC_RES_INVALID_COMMAND;
+		else
+			rv = host_command_process(&sub);
+
+		/* Only pass back as much as the host made room for */
+		if (rv == EC_RES_SUCCESS &&
+		    sub.response_size > req->response_max)
+			rv = EC_RES_INVALID_RESPONSE;
+
+		resp->result = rv;
+		resp->size = rv == EC_RES_SUCCESS ? sub.response_size : 0;
+		memcpy(resp + 1, scratch, resp->size);
+		memset((uint8_t *)(resp + 1) + resp->size, 0,
+		       EC_BATCH_ALIGN(resp->size) - resp->size);
+
+		in += sizeof(*req) + EC_BATCH_ALIGN(req->size);
+		out += sizeof(*resp) + EC_BATCH_ALIGN(resp->size);
+	}
+
+	r->count = i;
+	memset(r->reserved, 0, sizeof(r->reserved));
+	args->response_size = out - (uint8_t *)args->response;
+
+	shared_mem_release(params);
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_BATCH,
+		     host_command_batch,
+		     EC_VER_MASK(0));
+#endif
+
 /**
  * Print debug output for the host command request, before it's processed.
  *
@@ -559,6 +763,51 @@ static void host_command_debug_request(struct host_cmd_handler_args *args)
 		CPRINTS("HC 0x%02x", args->command);
 }
 
+/**
+ * Run the handler for a command, if it supports the requested version.
+ *
+ * @param cmd		Command to run
+ * @param args		Host command args
+ * @return The result of the command.
+ */
+static int run_handler(const struct host_command *cmd,
+		       struct host_cmd_handler_args *args)
+{
+#ifdef CONFIG_HOSTCMD_STATS
+	struct host_command_stats *stats = cmd->stats;
+	uint32_t t0 = get_time().le.lo;
+	uint32_t run_time;
+#endif
+	int rv;
+
+	if (!(EC_VER_MASK(args->version) & cmd->version_mask))
+		rv = EC_RES_INVALID_VERSION;
+	else
+		rv = cmd->handler(args);
+
+#ifdef CONFIG_HOSTCMD_STATS
+	run_time = get_time().le.lo - t0;
+	stats->calls++;
+	if (rv != EC_RES_SUCCESS && rv != EC_RES_IN_PROGRESS)
+		stats->errors++;
+	if (run_time > stats->max_time)
+		stats->max_time = run_time;
+	stats->total_time += run_time;
+#endif
+
+	return rv;
+}
+
+#ifdef CONFIG_HOSTCMD_STATS
+static void host_command_stats_reset(void)
+{
+	const struct host_command *cmd;
+
+	for (cmd = __hcmds; cmd < __hcmds_end; cmd++)
+		memset(cmd->stats, 0, sizeof(*cmd->stats));
+}
+#endif
+
 enum ec_status host_command_process(struct host_cmd_handler_args *args)
 {
 	const struct host_command *cmd;
@@ -588,10 +837,8 @@ enum ec_status host_command_process(struct host_cmd_handler_args *args)
 		cmd = find_host_command(args->command);
 		if (!cmd)
 			rv = EC_RES_INVALID_COMMAND;
-		else if (!(EC_VER_MASK(args->version) & cmd->version_mask))
-			rv = EC_RES_INVALID_VERSION;
 		else
-			rv = cmd->handler(args);
+			rv = run_handler(cmd, args);
 	}
 
 	if (rv != EC_RES_SUCCESS)
@@ -604,7 +851,90 @@ enum ec_status host_command_process(struct host_cmd_handler_args *args)
 	return rv;
 }
 
+/* Call a background routine until it's done, for callers which can't wait */
+static int async_run_all(struct host_cmd_handler_args *args,
+			 int (*routine)(struct host_cmd_handler_args *args))
+{
+	int rv;
+
+	do {
+		rv = routine(args);
+	} while (rv == EC_RES_IN_PROGRESS);
+
+	return rv;
+}
+
 #ifdef CONFIG_HOST_COMMAND_STATUS
+static void host_command_async_worker(void)
+{
+	int rv = async_routine(&async_args);
+
+	/*
+	 * Let other hooks and deferred calls run before the next step, and
+	 * let the hook task sleep so it doesn't spin between steps.
+	 */
+	if (rv == EC_RES_IN_PROGRESS) {
+		hook_call_deferred(host_command_async_worker,
+				   ASYNC_STEP_DELAY_US);
+		return;
+	}
+
+	if (async_args.response_size < 0 ||
+	    async_args.response_size > async_args.response_max)
+		rv = EC_RES_INVALID_RESPONSE;
+
+	CPRINTS("HC pending done, size=%d, result=%d",
+		async_args.response_size, rv);
+
+	/* Save the result before the host can see the command is done */
+	interrupt_disable();
+	saved_result = rv;
+	saved_response_size = rv == EC_RES_SUCCESS ?
+		async_args.response_size : 0;
+	command_pending = 0;
+	interrupt_enable();
+}
+DECLARE_DEFERRED(host_command_async_worker);
+
+int host_command_async(struct host_cmd_handler_args *args,
+		       int (*routine)(struct host_cmd_handler_args *args))
+{
+	/* Routines may keep state between steps, so run one at a time */
+	if (command_pending)
+		return EC_RES_BUSY;
+
+	/*
+	 * Only commands from the host interface can be finished later; the
+	 * console, batches and tests need the result now.
+	 */
+	if (!args->send_response || args->params_size > sizeof(async_params))
+		return async_run_all(args, routine);
+
+	async_routine = routine;
+	async_args = *args;
+	async_args.send_response = NULL;
+	memcpy(async_params, args->params, args->params_size);
+	async_args.params = async_params;
+	async_args.response = async_response;
+	async_args.response_max = MIN(args->response_max,
+				      (int)sizeof(async_response));
+	async_args.response_size = 0;
+
+	saved_result = EC_RES_UNAVAILABLE;
+	saved_response_size = 0;
+	command_pending = 1;
+	CPRINTS("HC pending");
+
+	hook_call_deferred_data(&host_command_async_worker_data, 0);
+
+	return EC_RES_IN_PROGRESS;
+}
+
+int host_command_async_pending(void)
+{
+	return command_pending;
+}
+
 /* Returns current command status (busy or not) */
 static int host_command_get_comms_status(struct host_cmd_handler_args *args)
 {
@@ -623,18 +953,38 @@ DECLARE_HOST_COMMAND(EC_CMD_GET_COMMS_STATUS,
 /* Resend the last saved response */
 static int host_command_resend_response(struct host_cmd_handler_args *args)
 {
-	/* Handle resending response */
-	args->result = saved_result;
-	args->response_size = 0;
+	int rv = saved_result;
+
+	if (command_pending)
+		return EC_RES_BUSY;
+
+	/* Hand over the result of the last slow command, once */
+	if (saved_response_size > args->response_max)
+		rv = EC_RES_RESPONSE_TOO_BIG;
+	else if (saved_response_size)
+		memcpy(args->response, async_response, saved_response_size);
+	args->response_size = rv == EC_RES_SUCCESS ? saved_response_size : 0;
 
 	saved_result = EC_RES_UNAVAILABLE;
+	saved_response_size = 0;
 
-	return EC_SUCCESS;
+	return rv;
 }
 
 DECLARE_HOST_COMMAND(EC_CMD_RESEND_RESPONSE,
 		     host_command_resend_response,
 		     EC_VER_MASK(0));
+#else
+int host_command_async(struct host_cmd_handler_args *args,
+		       int (*routine)(struct host_cmd_handler_args *args))
+{
+	return async_run_all(args, routine);
+}
+
+int host_command_async_pending(void)
+{
+	return 0;
+}
 #endif /* CONFIG_HOST_COMMAND_STATUS */
 
 
@@ -889,3 +1239,61 @@ DECLARE_CONSOLE_COMMAND(hcdebug, command_hcdebug,
 			"hcdebug [off | normal | every | params]",
 			"Set host command debug output mode",
 			NULL);
+
+#ifdef CONFIG_HOSTCMD_STATS
+static int command_hcstats(int argc, char **argv)
+{
+	const struct host_command *cmd;
+	const struct host_command_stats *stats;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset"))
+			return EC_ERROR_PARAM1;
+		host_command_stats_reset();
+		return EC_SUCCESS;
+	}
+
+	ccputs("Cmd      Calls  Errors   Max us   Avg us\n");
+	for (cmd = __hcmds; cmd < __hcmds_end; cmd++) {
+		stats = cmd->stats;
+		if (!stats->calls)
+			continue;
+		ccprintf("0x%04x %7d %7d %8d %8d\n", cmd->command,
+			 stats->calls, stats->errors, stats->max_time,
+			 (int)(stats->total_time / stats->calls));
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(hcstats, command_hcstats,
+			"[reset]",
+			"Print/reset host command statistics",
+			NULL);
+
+static int host_command_stats(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_host_command_stats *p = args->params;
+	struct ec_response_host_command_stats *r = args->response;
+	const struct host_command *cmd = __hcmds + p->index;
+
+	if (p->index >= __hcmds_end - __hcmds)
+		return EC_RES_INVALID_PARAM;
+
+	r->count = __hcmds_end - __hcmds;
+	r->command = cmd->command;
+	r->calls = cmd->stats->calls;
+	r->errors = cmd->stats->errors;
+	r->max_time = cmd->stats->max_time;
+	r->total_time = cmd->stats->total_time;
+
+	if (p->flags & EC_HOST_COMMAND_STATS_FLAG_RESET)
+		host_command_stats_reset();
+
+	args->response_size = sizeof(*r);
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_HOST_COMMAND_STATS,
+		     host_command_stats,
+		     EC_VER_MASK(0));
+#endif
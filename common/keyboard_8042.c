@@ -69,7 +69,7 @@ enum scancode_set_list {
  */
 static struct mutex to_host_mutex;
 
-static struct queue const to_host = QUEUE_NULL(16, uint8_t);
+QUEUE_TYPED(to_host, 16, uint8_t, queue_policy_null);
 
 /* Queue command/data from the host */
 enum {
@@ -92,7 +92,7 @@ struct host_byte {
  *
  * Hence, 5 (actually 4 plus one spare) is large enough, but use 8 for safety.
  */
-static struct queue const from_host = QUEUE_NULL(8, struct host_byte);
+QUEUE_TYPED(from_host, 8, struct host_byte, queue_policy_null);
 
 static int i8042_irq_enabled;
 
@@ -195,7 +195,7 @@ void keyboard_host_write(int data, int is_cmd)
 
 	h.type = is_cmd ? HOST_COMMAND : HOST_DATA;
 	h.byte = data;
-	queue_add_unit(&from_host, &h);
+	from_host_add_unit(&h);
 	task_wake(TASK_ID_KEYPROTO);
 }
 
@@ -776,7 +776,7 @@ static void i8042_handle_from_host(void)
 	int ret_len;
 	uint8_t output[MAX_SCAN_CODE_LEN];
 
-	while (queue_remove_unit(&from_host, &h)) {
+	while (from_host_remove_unit(&h)) {
 		if (h.type == HOST_COMMAND)
 			ret_len = handle_keyboard_command(h.byte, output);
 		else
@@ -898,7 +898,7 @@ void keyboard_protocol_task(void)
 
 			/* Get a char from buffer. */
 			kblog_put('k', to_host.state->head);
-			queue_remove_unit(&to_host, &chr);
+			to_host_remove_unit(&chr);
 			kblog_put('K', chr);
 
 			/* Write to host. */
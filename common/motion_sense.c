@@ -385,6 +385,7 @@ static inline void update_sense_data(uint8_t *lpc_status,
 	 * bit is not set and that the counter remains the same before
 	 * and after reading the data.
 	 */
+	host_memmap_update_begin();
 	*lpc_status |= EC_MEMMAP_ACC_STATUS_BUSY_BIT;
 
 	/*
@@ -415,6 +416,7 @@ static inline void update_sense_data(uint8_t *lpc_status,
 	*psample_id = (*psample_id + 1) &
 			EC_MEMMAP_ACC_STATUS_SAMPLE_ID_MASK;
 	*lpc_status = EC_MEMMAP_ACC_STATUS_PRESENCE_BIT | *psample_id;
+	host_memmap_update_end();
 }
 #endif
 
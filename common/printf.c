@@ -44,22 +44,127 @@ static int hexdigit(int c)
 	return c > 9 ? (c + 'a' - 10) : (c + '0');
 }
 
+/**
+ * Convert an unsigned number to decimal, working backwards from the end of a
+ * buffer.
+ *
+ * Digits are produced 32 bits at a time with division by a constant, which the
+ * compiler turns into a multiply.  Only numbers which don't fit in 32 bits
+ * need a real division, and then just one per 9 digits instead of one per
+ * digit.
+ *
+ * @param p	Pointer just past the last digit to write
+ * @param v	Number to convert
+ * @return Pointer to the first digit written.
+ */
+#ifdef NO_UINT64_SUPPORT
+static char *utoa_dec(char *p, uint32_t v)
+{
+	uint32_t lo = v;
+#else
+static char *utoa_dec(char *p, uint64_t v)
+{
+	uint32_t lo;
+	int i;
+
+	while (v >> 32) {
+		lo = divmod(&v, 1000000000);
+		for (i = 0; i < 9; i++) {
+			*(--p) = '0' + lo % 10;
+			lo /= 10;
+		}
+	}
+	lo = v;
+#endif
+
+	do {
+		*(--p) = '0' + lo % 10;
+		lo /= 10;
+	} while (lo);
+
+	return p;
+}
+
+/**
+ * Convert an unsigned number to a power-of-two base, working backwards from
+ * the end of a buffer.
+ *
+ * @param p	Pointer just past the last digit to write
+ * @param v	Number to convert
+ * @param shift	Bits per digit; 1 for binary, 4 for hex
+ * @param upper	Use upper-case hex digits
+ * @return Pointer to the first digit written.
+ */
+#ifdef NO_UINT64_SUPPORT
+static char *utoa_pow2(char *p, uint32_t v, int shift, int upper)
+#else
+static char *utoa_pow2(char *p, uint64_t v, int shift, int upper)
+#endif
+{
+	const char *digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+	const int mask = (1 << shift) - 1;
+	uint32_t lo;
+
+#ifndef NO_UINT64_SUPPORT
+	while (v >> 32) {
+		*(--p) = digits[v & mask];
+		v >>= shift;
+	}
+#endif
+	lo = v;
+
+	do {
+		*(--p) = digits[lo & mask];
+		lo >>= shift;
+	} while (lo);
+
+	return p;
+}
+
 /* Flags for vfnprintf() flags */
 #define PF_LEFT		(1 << 0)  /* Left-justify */
 #define PF_PADZERO	(1 << 1)  /* Pad with 0's not spaces */
 #define PF_NEGATIVE	(1 << 2)  /* Number is negative */
 #define PF_64BIT	(1 << 3)  /* Number is 64-bit */
 
-int vfnprintf(int (*addchar)(void *context, int c), void *context,
-	      const char *format, va_list args)
+/**
+ * Add padding characters.
+ *
+ * @param addstr	Output function
+ * @param context	Context for output function
+ * @param c		Padding character; ' ' or '0'
+ * @param count		Number of characters to add
+ * @return 0 if all characters were added, non-zero if output overflowed.
+ */
+static int addpad(int (*addstr)(void *context, const char *str, int len),
+		  void *context, int c, int count)
+{
+	static const char spaces[] = "                ";
+	static const char zeros[] = "0000000000000000";
+	const char *pad = c == '0' ? zeros : spaces;
+	int len;
+
+	while (count > 0) {
+		len = MIN(count, (int)sizeof(spaces) - 1);
+		if (addstr(context, pad, len))
+			return 1;
+		count -= len;
+	}
+
+	return 0;
+}
+
+int vfnprintf_str(int (*addstr)(void *context, const char *str, int len),
+		  void *context, const char *format, va_list args)
 {
 	/*
 	 * Longest uint64 in decimal = 20
 	 * Longest uint32 in binary  = 32
 	 * + sign bit
+	 * + decimal point
 	 * + terminating null
 	 */
-	char intbuf[34];
+	char intbuf[35];
 	int flags;
 	int pad_width;
 	int precision;
@@ -67,11 +172,14 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 	int vlen;
 
 	while (*format) {
-		int c = *format++;
+		int c = *format;
 
-		/* Copy normal characters */
+		/* Copy runs of normal characters */
 		if (c != '%') {
-			if (addchar(context, c))
+			vstr = (char *)format;
+			while (*format && *format != '%')
+				format++;
+			if (addstr(context, vstr, format - vstr))
 				return EC_ERROR_OVERFLOW;
 			continue;
 		}
@@ -80,19 +188,22 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 		flags = 0;
 
 		/* Get first format character */
+		format++;
 		c = *format++;
 
 		/* Send "%" for "%%" input */
 		if (c == '%' || c == '\0') {
-			if (addchar(context, '%'))
+			if (addstr(context, "%", 1))
 				return EC_ERROR_OVERFLOW;
+			if (!c)
+				break;
 			continue;
 		}
 
 		/* Handle %c */
 		if (c == 'c') {
-			c = va_arg(args, int);
-			if (addchar(context, c))
+			intbuf[0] = va_arg(args, int);
+			if (addstr(context, intbuf, 1))
 				return EC_ERROR_OVERFLOW;
 			continue;
 		}
@@ -160,9 +271,15 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 				continue;
 			}
 
-			for (; precision; precision--, vstr++) {
-				if (addchar(context, hexdigit(*vstr >> 4)) ||
-				    addchar(context, hexdigit(*vstr)))
+			/* Convert a buffer's worth of bytes at a time */
+			while (precision) {
+				vlen = MIN(precision, (int)sizeof(intbuf) / 2);
+				precision -= vlen;
+				for (c = 0; c < vlen; c++, vstr++) {
+					intbuf[2 * c] = hexdigit(*vstr >> 4);
+					intbuf[2 * c + 1] = hexdigit(*vstr);
+				}
+				if (addstr(context, intbuf, 2 * vlen))
 					return EC_ERROR_OVERFLOW;
 			}
 
@@ -236,31 +353,45 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 
 			/*
 			 * Fixed-point precision must fit in our buffer.
-			 * Leave space for "0." and the terminating null.
+			 * Leave space for "0.", the sign and the terminating
+			 * null.
 			 */
-			if (precision > sizeof(intbuf) - 3)
-				precision = sizeof(intbuf) - 3;
-
-			/*
-			 * Handle digits to right of decimal for fixed point
-			 * numbers.
-			 */
-			for (vlen = 0; vlen < precision; vlen++)
-				*(--vstr) = '0' + divmod(&v, 10);
-			if (precision)
+			if (precision > sizeof(intbuf) - 4)
+				precision = sizeof(intbuf) - 4;
+
+			if (base == 10) {
+				vstr = utoa_dec(vstr, v);
+
+				/*
+				 * Fixed point numbers need a digit to the left
+				 * of the decimal point; slide that part over to
+				 * make room for the point itself.
+				 */
+				if (precision) {
+					vlen = intbuf + sizeof(intbuf) - 1 -
+						vstr;
+					while (vlen++ <= precision)
+						*(--vstr) = '0';
+					vlen = intbuf + sizeof(intbuf) - 1 -
+						vstr - precision;
+					memmove(vstr - 1, vstr, vlen);
+					vstr--;
+					vstr[vlen] = '.';
+				}
+			} else if (!precision) {
+				vstr = utoa_pow2(vstr, v, base == 16 ? 4 : 1,
+						 c == 'X');
+			} else {
+				/*
+				 * Fixed point in another base makes little
+				 * sense, but keep the digits to the right of
+				 * the decimal point in base 10 as always.
+				 */
+				for (vlen = 0; vlen < precision; vlen++)
+					*(--vstr) = '0' + divmod(&v, 10);
 				*(--vstr) = '.';
-
-			if (!v)
-				*(--vstr) = '0';
-
-			while (v) {
-				int digit = divmod(&v, base);
-				if (digit < 10)
-					*(--vstr) = '0' + digit;
-				else if (c == 'X')
-					*(--vstr) = 'A' + digit - 10;
-				else
-					*(--vstr) = 'a' + digit - 10;
+				vstr = utoa_pow2(vstr, v, base == 16 ? 4 : 1,
+						 c == 'X');
 			}
 
 			if (flags & PF_NEGATIVE)
@@ -284,25 +415,56 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 		if (!precision)
 			precision = MAX(vlen, pad_width);
 
-		while (vlen < pad_width && !(flags & PF_LEFT)) {
-			if (addchar(context, flags & PF_PADZERO ? '0' : ' '))
-				return EC_ERROR_OVERFLOW;
-			vlen++;
-		}
-		while (*vstr && --precision >= 0)
-			if (addchar(context, *vstr++))
-				return EC_ERROR_OVERFLOW;
-		while (vlen < pad_width && flags & PF_LEFT) {
-			if (addchar(context, ' '))
-				return EC_ERROR_OVERFLOW;
-			vlen++;
-		}
+		if (!(flags & PF_LEFT) &&
+		    addpad(addstr, context, flags & PF_PADZERO ? '0' : ' ',
+			   pad_width - vlen))
+			return EC_ERROR_OVERFLOW;
+		if (addstr(context, vstr, MIN(vlen, precision)))
+			return EC_ERROR_OVERFLOW;
+		if ((flags & PF_LEFT) &&
+		    addpad(addstr, context, ' ', pad_width - vlen))
+			return EC_ERROR_OVERFLOW;
 	}
 
 	/* If we're still here, we consumed all output */
 	return EC_SUCCESS;
 }
 
+/* Context for vfnprintf(), wrapping a character output function */
+struct addchar_context {
+	int (*addchar)(void *context, int c);
+	void *context;
+};
+
+/**
+ * Pass a run of characters to a character output function.
+ *
+ * @param context	Context; struct addchar_context
+ * @param str		Characters to add
+ * @param len		Number of characters
+ * @return 0 if all characters added, 1 if output overflowed.
+ */
+static int addchar_addstr(void *context, const char *str, int len)
+{
+	struct addchar_context *ctx = (struct addchar_context *)context;
+
+	while (len--) {
+		if (ctx->addchar(ctx->context, *str++))
+			return 1;
+	}
+	return 0;
+}
+
+int vfnprintf(int (*addchar)(void *context, int c), void *context,
+	      const char *format, va_list args)
+{
+	struct addchar_context ctx;
+
+	ctx.addchar = addchar;
+	ctx.context = context;
+	return vfnprintf_str(addchar_addstr, &ctx, format, args);
+}
+
 /* Context for snprintf() */
 struct snprintf_context {
 	char *str;
@@ -310,22 +472,22 @@ struct snprintf_context {
 };
 
 /**
- * Add a character to the string context.
+ * Add a run of characters to the string context.
  *
- * @param context	Context receiving character
- * @param c		Character to add
- * @return 0 if character added, 1 if character dropped because no space.
+ * @param context	Context receiving characters
+ * @param str		Characters to add
+ * @param len		Number of characters
+ * @return 0 if all characters added, 1 if some were dropped for lack of space.
  */
-static int snprintf_addchar(void *context, int c)
+static int snprintf_addstr(void *context, const char *str, int len)
 {
 	struct snprintf_context *ctx = (struct snprintf_context *)context;
+	int n = MIN(len, ctx->size);
 
-	if (!ctx->size)
-		return 1;
-
-	*(ctx->str++) = c;
-	ctx->size--;
-	return 0;
+	memcpy(ctx->str, str, n);
+	ctx->str += n;
+	ctx->size -= n;
+	return n < len;
 }
 
 int snprintf(char *str, int size, const char *format, ...)
@@ -341,7 +503,7 @@ int snprintf(char *str, int size, const char *format, ...)
 	ctx.size = size - 1;  /* Reserve space for terminating '\0' */
 
 	va_start(args, format);
-	rv = vfnprintf(snprintf_addchar, &ctx, format, args);
+	rv = vfnprintf_str(snprintf_addstr, &ctx, format, args);
 	va_end(args);
 
 	/* Terminate string */
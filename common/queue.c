@@ -29,12 +29,13 @@ void queue_init(struct queue const *q)
 
 int queue_is_empty(struct queue const *q)
 {
-	return q->state->head == q->state->tail;
+	return queue_count(q) == 0;
 }
 
 size_t queue_count(struct queue const *q)
 {
-	return q->state->tail - q->state->head;
+	return queue_load_acquire(&q->state->tail) -
+	       queue_load_acquire(&q->state->head);
 }
 
 size_t queue_space(struct queue const *q)
@@ -100,7 +101,7 @@ size_t queue_advance_head(struct queue const *q, size_t count)
 {
 	size_t transfer = MIN(count, queue_count(q));
 
-	q->state->head += transfer;
+	queue_store_release(&q->state->head, q->state->head + transfer);
 
 	q->policy->remove(q->policy, transfer);
 
@@ -111,7 +112,7 @@ size_t queue_advance_tail(struct queue const *q, size_t count)
 {
 	size_t transfer = MIN(count, queue_space(q));
 
-	q->state->tail += transfer;
+	queue_store_release(&q->state->tail, q->state->tail + transfer);
 
 	q->policy->add(q->policy, transfer);
 
@@ -216,6 +217,67 @@ size_t queue_remove_memcpy(struct queue const *q,
 	return queue_advance_head(q, transfer);
 }
 
+void queue_batch_begin_add(struct queue const *q, struct queue_batch *batch)
+{
+	batch->index = q->state->tail;
+	batch->limit = queue_space(q);
+	batch->count = 0;
+}
+
+size_t queue_batch_add_unit(struct queue const *q,
+			    struct queue_batch *batch,
+			    const void *src)
+{
+	size_t tail = (batch->index + batch->count) & (q->buffer_units - 1);
+
+	if (batch->count == batch->limit)
+		return 0;
+
+	if (q->unit_bytes == 1)
+		q->buffer[tail] = *((uint8_t *) src);
+	else
+		memcpy(q->buffer + tail * q->unit_bytes, src, q->unit_bytes);
+
+	batch->count++;
+	return 1;
+}
+
+size_t queue_batch_commit_add(struct queue const *q, struct queue_batch *batch)
+{
+	return queue_advance_tail(q, batch->count);
+}
+
+void queue_batch_begin_remove(struct queue const *q, struct queue_batch *batch)
+{
+	batch->index = q->state->head;
+	batch->limit = queue_count(q);
+	batch->count = 0;
+}
+
+size_t queue_batch_remove_unit(struct queue const *q,
+			       struct queue_batch *batch,
+			       void *dest)
+{
+	size_t head = (batch->index + batch->count) & (q->buffer_units - 1);
+
+	if (batch->count == batch->limit)
+		return 0;
+
+	if (q->unit_bytes == 1)
+		*((uint8_t *) dest) = q->buffer[head];
+	else
+		memcpy(dest, q->buffer + head * q->unit_bytes, q->unit_bytes);
+
+	batch->count++;
+	return 1;
+}
+
+size_t queue_batch_commit_remove(struct queue const *q,
+				 struct queue_batch *batch)
+{
+	return queue_advance_head(q, batch->count);
+}
+
 size_t queue_peek_units(struct queue const *q,
 			void *dest,
 			size_t i,
@@ -85,6 +85,127 @@ static void mont_mul(const struct rsa_public_key *key,
 		mont_mul_add(key, c, a[i], b);
 }
 
+/**
+ * Montgomery c[] = a[] * a[] / R % mod
+ *
+ * Squares first, then reduces.  Each cross product a[i] * a[j] appears
+ * twice in the square, so it is only computed once and the sum doubled,
+ * which saves about a quarter of the multiplies of mont_mul().  Both the
+ * cross products and the reduction work on two rows at a time, like
+ * mont_mul_add(), so each word of t[] is loaded and stored half as often.
+ *
+ * @param c	Result; may be the same as a
+ * @param t	Temporary space, 2 x RSANUMWORDS elements long
+ */
+static void mont_sqr(const struct rsa_public_key *key,
+		     uint32_t *c,
+		     const uint32_t *a,
+		     uint32_t *t)
+{
+	const uint32_t *n = key->n;
+	const uint32_t n0inv = key->n0inv;
+	uint64_t A, B;
+	uint32_t d0, d1, w, carry;
+	uint32_t i, j;
+
+	/* Sum of the cross products; rows i and i + 1 together */
+	for (i = 0; i < RSANUMWORDS; ++i)
+		t[i] = 0;
+
+	for (i = 0; i < RSANUMWORDS - 2; i += 2) {
+		A = (uint64_t)a[i] * a[i + 1] + t[2 * i + 1];
+		t[2 * i + 1] = (uint32_t)A;
+		A = (A >> 32) + (uint64_t)a[i] * a[i + 2] + t[2 * i + 2];
+		t[2 * i + 2] = (uint32_t)A;
+		B = 0;
+		for (j = i + 3; j < RSANUMWORDS; ++j) {
+			A = (A >> 32) + (uint64_t)a[i] * a[j] + t[i + j];
+			B = (B >> 32) + (uint64_t)a[i + 1] * a[j - 1] +
+				(uint32_t)A;
+			t[i + j] = (uint32_t)B;
+		}
+		B = (B >> 32) + (uint64_t)a[i + 1] * a[RSANUMWORDS - 1] +
+			(A >> 32);
+		t[i + RSANUMWORDS] = (uint32_t)B;
+		t[i + RSANUMWORDS + 1] = (uint32_t)(B >> 32);
+	}
+
+	/* Last row has a single cross product */
+	A = (uint64_t)a[i] * a[i + 1] + t[2 * i + 1];
+	t[2 * i + 1] = (uint32_t)A;
+	t[2 * i + 2] = (uint32_t)(A >> 32);
+	t[2 * i + 3] = 0;
+
+	/*
+	 * Double it and add the squares.  This can't overflow, since the
+	 * total is a * a.
+	 */
+	A = 0;
+	carry = 0;
+	for (i = 0; i < RSANUMWORDS; ++i) {
+		w = t[2 * i];
+		A = (A >> 32) + (uint64_t)a[i] * a[i] + ((w << 1) | carry);
+		t[2 * i] = (uint32_t)A;
+		carry = w >> 31;
+
+		w = t[2 * i + 1];
+		A = (A >> 32) + ((w << 1) | carry);
+		t[2 * i + 1] = (uint32_t)A;
+		carry = w >> 31;
+	}
+
+	/*
+	 * Reduce: add multiples of mod to clear the low words, two at a time.
+	 * Row i + 1's multiplier depends on word i + 1 after row i is added,
+	 * so that's computed first.  The carry out of each pair of rows goes
+	 * into the word above them, with the next pair.
+	 */
+	carry = 0;
+	for (i = 0; i < RSANUMWORDS; i += 2) {
+		d0 = t[i] * n0inv;
+		A = (uint64_t)d0 * n[0] + t[i];
+		A = (A >> 32) + (uint64_t)d0 * n[1] + t[i + 1];
+		d1 = (uint32_t)A * n0inv;
+		B = (uint64_t)d1 * n[0] + (uint32_t)A;
+		for (j = 2; j < RSANUMWORDS; ++j) {
+			A = (A >> 32) + (uint64_t)d0 * n[j] + t[i + j];
+			B = (B >> 32) + (uint64_t)d1 * n[j - 1] + (uint32_t)A;
+			t[i + j] = (uint32_t)B;
+		}
+		A = (A >> 32) + t[i + RSANUMWORDS] + carry;
+		B = (B >> 32) + (uint64_t)d1 * n[RSANUMWORDS - 1] +
+			(uint32_t)A;
+		t[i + RSANUMWORDS] = (uint32_t)B;
+		A = (A >> 32) + (B >> 32) + t[i + RSANUMWORDS + 1];
+		t[i + RSANUMWORDS + 1] = (uint32_t)A;
+		carry = A >> 32;
+	}
+
+	/* The high words are the result */
+	for (i = 0; i < RSANUMWORDS; ++i)
+		c[i] = t[i + RSANUMWORDS];
+
+	if (carry)
+		sub_mod(key, c);
+}
+
+/**
+ * Convert from big endian byte array to little endian word array.
+ */
+static void bytes_to_words(uint32_t *a, const uint8_t *bytes)
+{
+	int i;
+
+	for (i = 0; i < RSANUMWORDS; ++i) {
+		uint32_t tmp =
+			(bytes[((RSANUMWORDS - 1 - i) * 4) + 0] << 24) |
+			(bytes[((RSANUMWORDS - 1 - i) * 4) + 1] << 16) |
+			(bytes[((RSANUMWORDS - 1 - i) * 4) + 2] << 8) |
+			(bytes[((RSANUMWORDS - 1 - i) * 4) + 3] << 0);
+		a[i] = tmp;
+	}
+}
+
 /**
  * In-place public exponentiation.
  *
@@ -96,27 +217,20 @@ static void mont_mul(const struct rsa_public_key *key,
 static void mod_pow_F4(const struct rsa_public_key *key, uint8_t *inout,
 		    uint32_t *workbuf32)
 {
-	uint32_t *a = workbuf32;
-	uint32_t *a_r = a + RSANUMWORDS;
-	uint32_t *aa_r = a_r + RSANUMWORDS;
-	uint32_t *aaa = aa_r;  /* Re-use location. */
+	uint32_t *a_r = workbuf32;
+	uint32_t *t = a_r + RSANUMWORDS;  /* 2 x RSANUMWORDS for mont_sqr() */
+	uint32_t *a = t + RSANUMWORDS;
+	uint32_t *aaa = t;
 	int i;
 
-	/* Convert from big endian byte array to little endian word array. */
-	for (i = 0; i < RSANUMWORDS; ++i) {
-		uint32_t tmp =
-			(inout[((RSANUMWORDS - 1 - i) * 4) + 0] << 24) |
-			(inout[((RSANUMWORDS - 1 - i) * 4) + 1] << 16) |
-			(inout[((RSANUMWORDS - 1 - i) * 4) + 2] << 8) |
-			(inout[((RSANUMWORDS - 1 - i) * 4) + 3] << 0);
-		a[i] = tmp;
-	}
+	bytes_to_words(a, inout);
 
 	mont_mul(key, a_r, a, key->rr);  /* a_r = a * RR / R mod M */
-	for (i = 0; i < 16; i += 2) {
-		mont_mul(key, aa_r, a_r, a_r); /* aa_r = a_r * a_r / R mod M */
-		mont_mul(key, a_r, aa_r, aa_r);/* a_r = aa_r * aa_r / R mod M */
-	}
+	for (i = 0; i < 16; ++i)
+		mont_sqr(key, a_r, a_r, t); /* a_r = a_r * a_r / R mod M */
+
+	/* Squaring used a's space, so convert the input again */
+	bytes_to_words(a, inout);
 	mont_mul(key, aaa, a_r, a);  /* aaa = a_r * a / R mod M */
 
 	/* Make sure aaa < mod; aaa is at most 1x mod too large. */
@@ -36,7 +36,11 @@
  */
 
 #include "sha256.h"
+#ifdef HOST_TOOLS_BUILD
+#include <string.h>
+#else
 #include "util.h"
+#endif
 
 #define SHFR(x, n)    (x >> n)
 #define ROTR(x, n)   ((x >> n) | (x << ((sizeof(x) << 3) - n)))
@@ -104,14 +108,6 @@ static const uint32_t sha256_k[64] = {
 	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
 	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
 
-#define SHA256_DIGESTINFO_LEN 19
-
-static const uint8_t SHA256_digestinfo[] = {
-	0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86,
-	0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05,
-	0x00, 0x04, 0x20
-};
-
 void SHA256_init(struct sha256_ctx *ctx)
 {
 	int i;
@@ -123,6 +119,21 @@ void SHA256_init(struct sha256_ctx *ctx)
 	ctx->tot_len = 0;
 }
 
+#ifdef CONFIG_SHA256_UNROLLED
+/* Eight rounds, after which the working variables are back in place */
+#define SHA256_EXP8(j)						\
+	{							\
+		SHA256_EXP(0, 1, 2, 3, 4, 5, 6, 7, (j) + 0);	\
+		SHA256_EXP(7, 0, 1, 2, 3, 4, 5, 6, (j) + 1);	\
+		SHA256_EXP(6, 7, 0, 1, 2, 3, 4, 5, (j) + 2);	\
+		SHA256_EXP(5, 6, 7, 0, 1, 2, 3, 4, (j) + 3);	\
+		SHA256_EXP(4, 5, 6, 7, 0, 1, 2, 3, (j) + 4);	\
+		SHA256_EXP(3, 4, 5, 6, 7, 0, 1, 2, (j) + 5);	\
+		SHA256_EXP(2, 3, 4, 5, 6, 7, 0, 1, (j) + 6);	\
+		SHA256_EXP(1, 2, 3, 4, 5, 6, 7, 0, (j) + 7);	\
+	}
+#endif
+
 static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
 			     unsigned int block_nb)
 {
@@ -145,6 +156,20 @@ static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
 		for (j = 0; j < 8; j++)
 			wv[j] = ctx->h[j];
 
+#ifdef CONFIG_SHA256_UNROLLED
+		/*
+		 * Rename the working variables instead of shifting them along
+		 * after every round.
+		 */
+		SHA256_EXP8(0);
+		SHA256_EXP8(8);
+		SHA256_EXP8(16);
+		SHA256_EXP8(24);
+		SHA256_EXP8(32);
+		SHA256_EXP8(40);
+		SHA256_EXP8(48);
+		SHA256_EXP8(56);
+#else
 		for (j = 0; j < 64; j++) {
 			t1 = wv[7] + SHA256_F2(wv[4]) + CH(wv[4], wv[5], wv[6])
 				+ sha256_k[j] + w[j];
@@ -158,6 +183,7 @@ static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
 			wv[1] = wv[0];
 			wv[0] = t1 + t2;
 		}
+#endif
 
 		for (j = 0; j < 8; j++)
 			ctx->h[j] += wv[j];
@@ -167,33 +193,35 @@ static void SHA256_transform(struct sha256_ctx *ctx, const uint8_t *message,
 void SHA256_update(struct sha256_ctx *ctx, const uint8_t *data, uint32_t len)
 {
 	unsigned int block_nb;
-	unsigned int new_len, rem_len, tmp_len;
-	const uint8_t *shifted_data;
-
-	tmp_len = SHA256_BLOCK_SIZE - ctx->len;
-	rem_len = len < tmp_len ? len : tmp_len;
-
-	memcpy(&ctx->block[ctx->len], data, rem_len);
-
-	if (ctx->len + len < SHA256_BLOCK_SIZE) {
-		ctx->len += len;
-		return;
+	unsigned int rem_len;
+
+	/* Top up a partial block left from last time */
+	if (ctx->len) {
+		rem_len = SHA256_BLOCK_SIZE - ctx->len;
+		if (rem_len > len)
+			rem_len = len;
+
+		memcpy(&ctx->block[ctx->len], data, rem_len);
+		ctx->len += rem_len;
+		if (ctx->len < SHA256_BLOCK_SIZE)
+			return;
+
+		SHA256_transform(ctx, ctx->block, 1);
+		ctx->tot_len += SHA256_BLOCK_SIZE;
+		ctx->len = 0;
+		data += rem_len;
+		len -= rem_len;
 	}
 
-	new_len = len - rem_len;
-	block_nb = new_len / SHA256_BLOCK_SIZE;
-
-	shifted_data = data + rem_len;
-
-	SHA256_transform(ctx, ctx->block, 1);
-	SHA256_transform(ctx, shifted_data, block_nb);
-
-	rem_len = new_len % SHA256_BLOCK_SIZE;
-
-	memcpy(ctx->block, &shifted_data[block_nb << 6], rem_len);
+	/* Hash whole blocks straight from the data, without copying them */
+	block_nb = len / SHA256_BLOCK_SIZE;
+	SHA256_transform(ctx, data, block_nb);
+	ctx->tot_len += block_nb << 6;
 
+	/* Keep what's left over for next time */
+	rem_len = len % SHA256_BLOCK_SIZE;
+	memcpy(ctx->block, &data[block_nb << 6], rem_len);
 	ctx->len = rem_len;
-	ctx->tot_len += (block_nb + 1) << 6;
 }
 
 uint8_t *SHA256_final(struct sha256_ctx *ctx)
@@ -0,0 +1,155 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Per-task wake-up latency and run time histograms */
+
+#include "atomic.h"
+#include "common.h"
+#include "console.h"
+#include "host_command.h"
+#include "task.h"
+#include "timer.h"
+#include "util.h"
+
+BUILD_ASSERT(TASK_ID_COUNT <= 32);
+
+struct task_stats {
+	uint32_t wake_latency[EC_TASK_STATS_BUCKETS];
+	uint32_t run_time[EC_TASK_STATS_BUCKETS];
+};
+
+static struct task_stats stats[TASK_ID_COUNT];
+
+/* Time the pending event was set, valid if the task's bit is set below */
+static uint32_t wake_time[TASK_ID_COUNT];
+static uint32_t wake_pending;
+
+/* Time the task last started running */
+static uint32_t run_start[TASK_ID_COUNT];
+
+/* Return the histogram bucket for a duration */
+static int bucket(uint32_t us)
+{
+	int b = us ? 32 - __builtin_clz(us) : 0;
+
+	return MIN(b, EC_TASK_STATS_BUCKETS - 1);
+}
+
+void task_stats_event_set(task_id_t tskid)
+{
+	/* A task which is already running doesn't need waking up */
+	if (tskid >= TASK_ID_COUNT || tskid == task_get_current() ||
+	    (wake_pending & (1 << tskid)))
+		return;
+
+	/*
+	 * An interrupt may set an event on the same task in between; that
+	 * only moves the start of the measurement a little later.
+	 */
+	wake_time[tskid] = get_time().le.lo;
+	atomic_or(&wake_pending, 1 << tskid);
+}
+
+void task_stats_switch(task_id_t from, task_id_t to)
+{
+	uint32_t now;
+
+	if (from == to)
+		return;
+
+	now = get_time().le.lo;
+
+	if (from < TASK_ID_COUNT)
+		stats[from].run_time[bucket(now - run_start[from])]++;
+
+	if (to < TASK_ID_COUNT) {
+		run_start[to] = now;
+		if (wake_pending & (1 << to)) {
+			atomic_clear(&wake_pending, 1 << to);
+			stats[to].wake_latency[bucket(now - wake_time[to])]++;
+		}
+	}
+}
+
+static void task_stats_reset(void)
+{
+	memset(stats, 0, sizeof(stats));
+}
+
+/*****************************************************************************/
+/* Console commands */
+
+static void print_histograms(const char *title, int run_time)
+{
+	int i, b;
+
+	ccprintf("%s (us):\n%-12s", title, "Task");
+	for (b = 0; b < EC_TASK_STATS_BUCKETS - 1; b++) {
+		if (b < 11)
+			ccprintf(" %5d", 1 << b);
+		else
+			ccprintf(" %4dK", 1 << (b - 10));
+	}
+	ccputs("  more\n");
+	cflush();
+
+	for (i = 0; i < TASK_ID_COUNT; i++) {
+		const uint32_t *hist = run_time ? stats[i].run_time :
+						  stats[i].wake_latency;
+
+		ccprintf("%-12s", task_get_name(i));
+		for (b = 0; b < EC_TASK_STATS_BUCKETS; b++)
+			ccprintf(" %5d", hist[b]);
+		ccputs("\n");
+		cflush();
+	}
+}
+
+static int command_task_stats(int argc, char **argv)
+{
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset"))
+			return EC_ERROR_PARAM1;
+		task_stats_reset();
+		return EC_SUCCESS;
+	}
+
+	print_histograms("Wake-up latency, under", 0);
+	print_histograms("Run time, under", 1);
+
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(taskstats, command_task_stats,
+			"[reset]",
+			"Print/reset task latency and run time histograms",
+			NULL);
+
+/*****************************************************************************/
+/* Host commands */
+
+static int host_command_task_stats(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_task_stats *p = args->params;
+	struct ec_response_task_stats *r = args->response;
+
+	if (p->task_id >= TASK_ID_COUNT)
+		return EC_RES_INVALID_PARAM;
+
+	r->task_count = TASK_ID_COUNT;
+	memset(r->reserved, 0, sizeof(r->reserved));
+	strzcpy(r->name, task_get_name(p->task_id), sizeof(r->name));
+	memcpy(r->wake_latency, stats[p->task_id].wake_latency,
+	       sizeof(r->wake_latency));
+	memcpy(r->run_time, stats[p->task_id].run_time, sizeof(r->run_time));
+
+	if (p->flags & EC_TASK_STATS_FLAG_RESET)
+		task_stats_reset();
+
+	args->response_size = sizeof(*r);
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_TASK_STATS,
+		     host_command_task_stats,
+		     EC_VER_MASK(0));
@@ -28,34 +28,36 @@ int temp_sensor_read(enum temp_sensor_id id, int *temp_ptr)
 
 static void update_mapped_memory(void)
 {
+	uint8_t temps[EC_TEMP_SENSOR_ENTRIES + EC_TEMP_SENSOR_B_ENTRIES];
+	int count = MIN(TEMP_SENSOR_COUNT, ARRAY_SIZE(temps));
 	int i, t;
-	uint8_t *mptr = host_get_memmap(EC_MEMMAP_TEMP_SENSOR);
-
-	for (i = 0; i < TEMP_SENSOR_COUNT; i++, mptr++) {
-		/*
-		 * Switch to second range if first one is full, or stop if
-		 * second range is also full.
-		 */
-		if (i == EC_TEMP_SENSOR_ENTRIES)
-			mptr = host_get_memmap(EC_MEMMAP_TEMP_SENSOR_B);
-		else if (i >= EC_TEMP_SENSOR_ENTRIES +
-			 EC_TEMP_SENSOR_B_ENTRIES)
-			break;
 
+	/* Read the sensors first, so the host never sees a partial update */
+	for (i = 0; i < count; i++) {
 		switch (temp_sensor_read(i, &t)) {
 		case EC_ERROR_NOT_POWERED:
-			*mptr = EC_TEMP_SENSOR_NOT_POWERED;
+			temps[i] = EC_TEMP_SENSOR_NOT_POWERED;
 			break;
 		case EC_ERROR_NOT_CALIBRATED:
-			*mptr = EC_TEMP_SENSOR_NOT_CALIBRATED;
+			temps[i] = EC_TEMP_SENSOR_NOT_CALIBRATED;
 			break;
 		case EC_SUCCESS:
-			*mptr = t - EC_TEMP_SENSOR_OFFSET;
+			temps[i] = t - EC_TEMP_SENSOR_OFFSET;
 			break;
 		default:
-			*mptr = EC_TEMP_SENSOR_ERROR;
+			temps[i] = EC_TEMP_SENSOR_ERROR;
 		}
 	}
+
+	/* Fill the first range, then the second one */
+	host_memmap_update_begin();
+	memcpy(host_get_memmap(EC_MEMMAP_TEMP_SENSOR), temps,
+	       MIN(count, EC_TEMP_SENSOR_ENTRIES));
+	if (count > EC_TEMP_SENSOR_ENTRIES)
+		memcpy(host_get_memmap(EC_MEMMAP_TEMP_SENSOR_B),
+		       temps + EC_TEMP_SENSOR_ENTRIES,
+		       count - EC_TEMP_SENSOR_ENTRIES);
+	host_memmap_update_end();
 }
 /* Run after other TEMP tasks, so sensors will have updated first. */
 DECLARE_HOOK(HOOK_SECOND, update_mapped_memory, HOOK_PRIO_TEMP_SENSOR_DONE);
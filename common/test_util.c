@@ -36,6 +36,7 @@ extern void __gcov_flush(void);
 
 void emulator_flush(void)
 {
+	emulator_trace_dump();
 	__gcov_flush();
 }
 
@@ -52,6 +53,7 @@ void register_test_end_hook(void)
 #else
 void emulator_flush(void)
 {
+	emulator_trace_dump();
 }
 
 void register_test_end_hook(void)
@@ -65,18 +67,28 @@ void test_reset(void)
 		__test_error_count = 0;
 }
 
+/* Report on the test run before announcing its result */
+static void test_report(void)
+{
+	emulator_print_time_report();
+	emulator_trace_dump();
+}
+
 void test_pass(void)
 {
+	test_report();
 	ccprintf("Pass!\n");
 }
 
 void test_fail(void)
 {
+	test_report();
 	ccprintf("Fail!\n");
 }
 
 void test_print_result(void)
 {
+	test_report();
 	if (__test_error_count)
 		ccprintf("Fail! (%d tests)\n", __test_error_count);
 	else
@@ -88,6 +100,13 @@ int test_get_error_count(void)
 	return __test_error_count;
 }
 
+void test_print_rate(int count, const char *what, const char *unit,
+		     uint64_t elapsed)
+{
+	ccprintf("%d %s in %d us: %d %s/sec\n", count, what, (int)elapsed,
+		 (int)(count * 1000000ull / (elapsed ? elapsed : 1)), unit);
+}
+
 uint32_t test_get_state(void)
 {
 	return system_get_scratchpad();
@@ -137,6 +156,7 @@ int test_send_host_command(int command, int version, const void *params,
 {
 	struct host_cmd_handler_args args;
 
+	args.send_response = NULL;
 	args.version = version;
 	args.command = command;
 	args.params = params;
@@ -45,6 +45,8 @@ static volatile int tx_buf_tail;
 static volatile char rx_buf[CONFIG_UART_RX_BUF_SIZE];
 static volatile int rx_buf_head;
 static volatile int rx_buf_tail;
+/* Bytes written to the transmit buffer since boot; wraps at 2^32 */
+static volatile uint32_t tx_total;
 static int tx_snapshot_head;
 static int tx_snapshot_tail;
 static int tx_last_snapshot_head;
@@ -95,10 +97,105 @@ static int __tx_char(void *context, int c)
 
 	tx_buf[tx_buf_head] = c;
 	tx_buf_head = tx_buf_next;
+	tx_total++;
 #endif
 	return 0;
 }
 
+#ifndef CONFIG_POLLING_UART
+/**
+ * Move a snapshot head past output which is about to overwrite it.
+ *
+ * This does for a whole run what __tx_char() does one character at a time:
+ * a snapshot head which the new characters reach is pushed along to just
+ * past them, but not past stop.
+ *
+ * @param head		Snapshot head to update
+ * @param count		Number of characters being added at tx_buf_head
+ * @param stop		Position the head must not move past, or -1
+ * @return The new snapshot head
+ */
+static int snapshot_head_past(int head, int count, int stop)
+{
+	int d = TX_BUF_DIFF(head, tx_buf_head);
+
+	if (d < 1 || d > count)
+		return head;
+
+	if (stop >= 0 && TX_BUF_DIFF(stop, tx_buf_head) > d &&
+	    TX_BUF_DIFF(stop, tx_buf_head) <= count + 1)
+		return stop;
+
+	return (tx_buf_head + count + 1) & (CONFIG_UART_TX_BUF_SIZE - 1);
+}
+
+/**
+ * Copy a run of characters with no newlines into the transmit buffer.
+ *
+ * @param str		Characters to write.
+ * @param len		Number of characters.
+ * @return 0 if the characters were transmitted, 1 if any were dropped.
+ */
+static int __tx_run(const char *str, int len)
+{
+	int room = TX_BUF_DIFF(tx_buf_tail, TX_BUF_NEXT(tx_buf_head));
+	int count = MIN(len, room);
+	int first = MIN(count, CONFIG_UART_TX_BUF_SIZE - tx_buf_head);
+
+	if (tx_last_snapshot_head != tx_snapshot_head)
+		tx_last_snapshot_head = snapshot_head_past(
+			tx_last_snapshot_head, count, tx_snapshot_head);
+	tx_next_snapshot_head = snapshot_head_past(tx_next_snapshot_head,
+						   count, -1);
+
+	/* At most two copies, if the run wraps around the end */
+	memcpy((char *)tx_buf + tx_buf_head, str, first);
+	memcpy((char *)tx_buf, str + first, count - first);
+	tx_buf_head = (tx_buf_head + count) & (CONFIG_UART_TX_BUF_SIZE - 1);
+	tx_total += count;
+
+	return count < len;
+}
+#endif
+
+/**
+ * Put a run of characters into the transmit buffer.
+ *
+ * @param context	Context; ignored.
+ * @param str		Characters to write.
+ * @param len		Number of characters.
+ * @return 0 if the characters were transmitted, 1 if any were dropped.
+ */
+static int __tx_str(void *context, const char *str, int len)
+{
+#ifdef CONFIG_POLLING_UART
+	while (len--) {
+		if (__tx_char(NULL, *str++))
+			return 1;
+	}
+	return 0;
+#else
+	int run;
+
+	while (len) {
+		/* Copy up to the next newline in bulk */
+		for (run = 0; run < len && str[run] != '\n'; run++)
+			;
+		if (run && __tx_run(str, run))
+			return 1;
+		if (run == len)
+			return 0;
+
+		/* Then let __tx_char() translate the newline */
+		if (__tx_char(NULL, '\n'))
+			return 1;
+		str += run + 1;
+		len -= run + 1;
+	}
+	return 0;
+#endif
+}
+
 #ifdef CONFIG_UART_TX_DMA
 
 /**
@@ -280,7 +377,7 @@ int uart_puts(const char *outstr)
 
 int uart_vprintf(const char *format, va_list args)
 {
-	int rv = vfnprintf(__tx_char, NULL, format, args);
+	int rv = vfnprintf_str(__tx_str, NULL, format, args);
 
 	if (!uart_suspended)
 		uart_tx_start();
@@ -431,6 +528,55 @@ static int console_read_helper(struct host_cmd_handler_args *args,
 	return EC_RES_SUCCESS;
 }
 
+/*
+ * Read the output written since a cursor.
+ *
+ * The head of the transmit buffer only moves as output is written, so a
+ * cursor's place in the buffer is just its low bits.  The copy is done with
+ * interrupts disabled, so it can't be overwritten while it's being read.
+ */
+static int console_read_cursor(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_console_read_v2 *p = args->params;
+	struct ec_response_console_read_v2 *r = args->response;
+	int space = args->response_max - sizeof(*r);
+	uint32_t cursor = p->cursor;
+	uint32_t oldest;
+	int len, pos, first;
+
+	if (space < 0)
+		return EC_RES_RESPONSE_TOO_BIG;
+
+	r->flags = 0;
+	memset(r->reserved, 0, sizeof(r->reserved));
+
+	interrupt_disable();
+
+	/* The buffer holds the newest CONFIG_UART_TX_BUF_SIZE - 1 bytes */
+	oldest = tx_total - MIN(tx_total, CONFIG_UART_TX_BUF_SIZE - 1);
+
+	/* A cursor from the future means the EC has rebooted since */
+	if ((int32_t)(cursor - oldest) < 0 ||
+	    (int32_t)(tx_total - cursor) < 0) {
+		cursor = oldest;
+		r->flags |= EC_CONSOLE_READ_FLAG_OVERRUN;
+	}
+
+	len = MIN(tx_total - cursor, space);
+	pos = cursor & (CONFIG_UART_TX_BUF_SIZE - 1);
+	first = MIN(len, CONFIG_UART_TX_BUF_SIZE - pos);
+	memcpy(r->data, (const char *)tx_buf + pos, first);
+	memcpy(r->data + first, (const char *)tx_buf, len - first);
+
+	r->cursor = cursor;
+	r->end = tx_total;
+
+	interrupt_enable();
+
+	args->response_size = sizeof(*r) + len;
+	return EC_RES_SUCCESS;
+}
+
 static int host_command_console_read(struct host_cmd_handler_args *args)
 {
 	const struct ec_params_console_read_v1 *p;
@@ -450,9 +596,11 @@ static int host_command_console_read(struct host_cmd_handler_args *args)
 		else if (p->subcmd == CONSOLE_READ_RECENT)
 			return console_read_helper(args,
 						   &tx_last_snapshot_head);
+	} else if (args->version == 2) {
+		return console_read_cursor(args);
 	}
 	return EC_RES_INVALID_PARAM;
 }
 DECLARE_HOST_COMMAND(EC_CMD_CONSOLE_READ,
 		     host_command_console_read,
-		     EC_VER_MASK(0) | EC_VER_MASK(1));
+		     EC_VER_MASK(0) | EC_VER_MASK(1) | EC_VER_MASK(2));
@@ -31,8 +31,18 @@ struct vboot_hash_tag {
 #define VBOOT_HASH_SYSJUMP_TAG 0x5648 /* "VH" */
 #define VBOOT_HASH_SYSJUMP_VERSION 1
 
-#define CHUNK_SIZE 1024       /* Bytes to hash per deferred call */
 #define WORK_INTERVAL_US 100  /* Delay between deferred calls */
+#define WORK_BUDGET_US 2000   /* Time to spend hashing per deferred call */
+
+/*
+ * Data is hashed in chunks, resized as we go so each one takes about
+ * CHUNK_TIME_US.  That keeps each deferred call close to its time budget
+ * however fast the flash and the core are.
+ */
+#define CHUNK_TIME_US 250
+#define CHUNK_SIZE 1024       /* Initial chunk size */
+#define CHUNK_SIZE_MIN 256
+#define CHUNK_SIZE_MAX 0x10000
 
 static uint32_t data_offset;
 static uint32_t data_size;
@@ -63,43 +73,41 @@ void vboot_hash_abort(void)
 	}
 }
 
-#ifndef CONFIG_FLASH_MAPPED
-
-static void vboot_hash_next_chunk(void);
+static int chunk_size = CHUNK_SIZE;
 
-static int read_and_hash_chunk(int offset, int size)
+/**
+ * Resize chunks given how long the last one took to hash.
+ *
+ * @param size		Size of the last chunk, in bytes
+ * @param elapsed_us	Time it took to read and hash it
+ */
+static void adjust_chunk_size(int size, uint32_t elapsed_us)
 {
-	char *buf;
-	int rv;
+	int new_size;
 
-	rv = shared_mem_acquire(size, &buf);
-	if (rv == EC_ERROR_BUSY) {
-		/* Couldn't update hash right now; try again later */
-		hook_call_deferred(vboot_hash_next_chunk, WORK_INTERVAL_US);
-		return rv;
-	} else if (rv != EC_SUCCESS) {
-		vboot_hash_abort();
-		return rv;
-	}
-
-	rv = flash_read(offset, size, buf);
-	if (rv == EC_SUCCESS)
-		SHA256_update(&ctx, (const uint8_t *)buf, size);
+	if (elapsed_us)
+		new_size = size * CHUNK_TIME_US / elapsed_us;
 	else
-		vboot_hash_abort();
+		new_size = chunk_size * 2;
 
-	shared_mem_release(buf);
-	return rv;
-}
+	new_size = MIN(MAX(new_size, CHUNK_SIZE_MIN), CHUNK_SIZE_MAX);
 
-#endif
+	/* Keep to whole blocks, so the hash doesn't buffer partial ones */
+	chunk_size = new_size & ~(SHA256_BLOCK_SIZE - 1);
+}
 
 /**
  * Do next chunk of hashing work, if any.
  */
 static void vboot_hash_next_chunk(void)
 {
+	timestamp_t start, t;
 	int size;
+#ifndef CONFIG_FLASH_MAPPED
+	char *buf;
+	int buf_size;
+	int rv;
+#endif
 
 	/* Handle abort */
 	if (want_abort) {
@@ -108,18 +116,55 @@ static void vboot_hash_next_chunk(void)
 		return;
 	}
 
-	/* Compute the next chunk of hash */
-	size = MIN(CHUNK_SIZE, data_size - curr_pos);
+#ifndef CONFIG_FLASH_MAPPED
+	/*
+	 * Borrow shared memory to read flash into, for this call only.  Take
+	 * enough for a chunk, or as much as there is.
+	 */
+	buf_size = MIN(chunk_size, shared_mem_size());
+	rv = shared_mem_acquire(buf_size, &buf);
+	if (rv == EC_ERROR_BUSY) {
+		/* Couldn't update hash right now; try again later */
+		hook_call_deferred(vboot_hash_next_chunk, WORK_INTERVAL_US);
+		return;
+	} else if (rv != EC_SUCCESS) {
+		in_progress = 0;
+		vboot_hash_abort();
+		return;
+	}
+#endif
+
+	/* Hash chunks until we've used up this call's time */
+	start = get_time();
+	do {
+		size = MIN(chunk_size, data_size - curr_pos);
+		t = get_time();
 
 #ifdef CONFIG_FLASH_MAPPED
-	SHA256_update(&ctx, (const uint8_t *)(CONFIG_FLASH_BASE +
-					      data_offset + curr_pos), size);
+		/* Hash straight from flash */
+		SHA256_update(&ctx, (const uint8_t *)(CONFIG_FLASH_BASE +
+						      data_offset + curr_pos),
+			      size);
 #else
-	if (read_and_hash_chunk(data_offset + curr_pos, size) != EC_SUCCESS)
-		return;
+		size = MIN(size, buf_size);
+		if (flash_read(data_offset + curr_pos, size, buf)) {
+			shared_mem_release(buf);
+			in_progress = 0;
+			vboot_hash_abort();
+			return;
+		}
+		SHA256_update(&ctx, (const uint8_t *)buf, size);
+#endif
+
+		adjust_chunk_size(size, get_time().val - t.val);
+		curr_pos += size;
+	} while (curr_pos < data_size && !want_abort &&
+		 get_time().val - start.val < WORK_BUDGET_US);
+
+#ifndef CONFIG_FLASH_MAPPED
+	shared_mem_release(buf);
 #endif
 
-	curr_pos += size;
 	if (curr_pos >= data_size) {
 		/* Store the final hash */
 		hash = SHA256_final(&ctx);
@@ -211,6 +211,11 @@ uint32_t *task_get_event_bitmap(task_id_t tskid)
 	return &tsk->events;
 }
 
+const char *task_get_name(task_id_t tskid)
+{
+	return task_names[tskid];
+}
+
 int task_start_called(void)
 {
 	return start_called;
@@ -288,6 +293,10 @@ void svc_handler(int desched, task_id_t resched)
 	need_resched_or_profiling = 0;
 #endif
 
+	/* The scratchpad context before the first switch is not a task */
+	task_stats_switch(current == (task_ *)scratchpad ?
+			  TASK_ID_INVALID : current - tasks, next - tasks);
+
 	/* Nothing to do */
 	if (next == current)
 		return;
@@ -381,6 +390,7 @@ uint32_t task_set_event(task_id_t tskid, uint32_t event, int wait)
 
 	/* Set the event bit in the receiver message bitmap */
 	atomic_or(&receiver->events, event);
+	task_stats_event_set(tskid);
 
 	/* Re-schedule if priorities have changed */
 	if (in_interrupt_context()) {
@@ -179,6 +179,11 @@ uint32_t *task_get_event_bitmap(task_id_t tskid)
 	return &tsk->events;
 }
 
+const char *task_get_name(task_id_t tskid)
+{
+	return task_names[tskid];
+}
+
 int task_start_called(void)
 {
 	return start_called;
@@ -242,6 +247,10 @@ task_  __attribute__((noinline)) *__svc_handler(int desched, task_id_t resched)
 	exc_end_time = t;
 #endif
 
+	/* The scratchpad context before the first switch is not a task */
+	task_stats_switch(current == (task_ *)scratchpad ?
+			  TASK_ID_INVALID : current - tasks, next - tasks);
+
 	/* Switch to new task */
 #ifdef CONFIG_TASK_PROFILING
 	if (next != current)
@@ -370,6 +379,7 @@ uint32_t task_set_event(task_id_t tskid, uint32_t event, int wait)
 
 	/* Set the event bit in the receiver message bitmap */
 	atomic_or(&receiver->events, event);
+	task_stats_event_set(tskid);
 
 	/* Re-schedule if priorities have changed */
 	if (in_interrupt_context()) {
@@ -5,6 +5,8 @@
 
 /* Entry point of unit test executable */
 
+#include <string.h>
+
 #include "console.h"
 #include "flash.h"
 #include "hooks.h"
@@ -22,15 +24,40 @@
 #define CPRINTS(format, args...) cprints(CC_SYSTEM, format, ## args)
 
 const char *__prog_name;
+char **__prog_argv;
 
 const char *__get_prog_name(void)
 {
 	return __prog_name;
 }
 
+char **__get_prog_argv(void)
+{
+	return __prog_argv;
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--virtual-time"))
+			emulator_set_virtual_time(1);
+		else if (!strncmp(argv[i], "--trace=", 8))
+			emulator_trace_enable(argv[i] + 8);
+#ifdef HAS_TASK_HOSTCMD
+		else if (!strncmp(argv[i], "--host-socket=", 14))
+			emulator_set_host_socket(argv[i] + 14);
+#endif
+	}
+}
+
 int main(int argc, char **argv)
 {
 	__prog_name = argv[0];
+	__prog_argv = argv;
+
+	parse_args(argc, argv);
 
 	/*
 	 * In order to properly service IRQs before task switching is enabled,
@@ -5,6 +5,8 @@
 
 /* Task scheduling / events module for Chrome EC operating system */
 
+#include <errno.h>
+#include <inttypes.h>
 #include <malloc.h>
 #include <pthread.h>
 #include <semaphore.h>
@@ -13,11 +15,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "atomic.h"
 #include "common.h"
+#include "compile_time_macros.h"
 #include "console.h"
 #include "host_task.h"
+#include "host_test.h"
 #include "task.h"
 #include "task_id.h"
 #include "test_util.h"
@@ -27,9 +32,11 @@
 
 struct emu_task_t {
 	pthread_t thread;
-	pthread_cond_t resume;
+	sem_t resume;
 	uint32_t event;
 	timestamp_t wake_time;
+	int heap_index; /* Position in wake_heap[], or -1 if not queued */
+	uint32_t trace_flow; /* Trace flow ID of the event which woke us */
 	uint8_t started;
 };
 
@@ -38,20 +45,34 @@ struct task_args {
 	void *d;
 };
 
+BUILD_ASSERT(TASK_ID_COUNT <= sizeof(uint32_t) * 8);
+
 static struct emu_task_t tasks[TASK_ID_COUNT];
-static pthread_cond_t scheduler_cond;
-static pthread_mutex_t run_lock;
+static sem_t scheduler_sem;
 static task_id_t running_task_id;
 static int task_started;
 
+/* Bitmap of tasks with pending events; higher bit is higher priority */
+static uint32_t tasks_ready;
+/* Bitmap of tasks whose wake time has passed */
+static uint32_t tasks_timed_out;
+/* Bitmap of tasks with a spawned thread, which are valid to be resumed */
+static uint32_t tasks_spawned;
+
+/* Min-heap of task IDs with a pending wake time, keyed by wake_time */
+static task_id_t wake_heap[TASK_ID_COUNT];
+static int wake_heap_size;
+
 static sem_t interrupt_sem;
 static pthread_mutex_t interrupt_lock;
 static pthread_t interrupt_thread;
 static int in_interrupt;
 static int interrupt_disabled;
 static void (*pending_isr)(void);
-static int generator_sleeping;
+static volatile int generator_sleeping;
 static timestamp_t generator_sleep_deadline;
+/* Posted to wake the interrupt generator in virtual time */
+static sem_t generator_sem;
 static int has_interrupt_generator = 1;
 
 static __thread task_id_t my_task_id; /* thread local task id */
@@ -93,11 +114,259 @@ static const char * const task_names[] = {
 };
 #undef TASK
 
+/*
+ * Context switch tracer.  When enabled with --trace=<file>, every task
+ * resume and suspend, every task_set_event() and every interrupt is logged
+ * with its virtual and wall clock timestamps into a ring buffer.  Slots are
+ * claimed with an atomic increment, so task threads, interrupts and the
+ * interrupt generator can all record without taking a lock.  At test end,
+ * reboot or exit, recording stops and the buffer is written out as Chrome
+ * trace event JSON, which can be loaded into chrome://tracing or Perfetto.
+ * Only the last boot is kept.
+ */
+#define TRACE_BUFFER_SIZE (1 << 18)  /* Events; must be a power of two */
+
+enum trace_event_type {
+	TRACE_RESUME,
+	TRACE_SUSPEND,
+	TRACE_SET_EVENT,
+	TRACE_ISR_ENTER,
+	TRACE_ISR_EXIT,
+};
+
+struct trace_event {
+	uint64_t virt_us;
+	uint64_t wall_us;
+	uint32_t flow;  /* Flow ID linking a set_event to the task it wakes */
+	uint32_t event; /* Event bits, for TRACE_SET_EVENT */
+	uint8_t type;
+	uint8_t task;   /* Task which logged the event */
+	uint8_t target; /* Task woken, for TRACE_SET_EVENT */
+};
+
+/* Track ID for interrupt handlers, after all task IDs */
+#define TRACE_TID_ISR TASK_ID_COUNT
+
+static struct trace_event *trace_buf;
+static int trace_enabled;
+static uint32_t trace_head;
+static uint32_t trace_next_flow;
+static const char *trace_path;
+
+static uint32_t trace_new_flow(void)
+{
+	return __atomic_add_fetch(&trace_next_flow, 1, __ATOMIC_RELAXED);
+}
+
+static void trace_event(enum trace_event_type type, task_id_t task,
+			task_id_t target, uint32_t event, uint32_t flow)
+{
+	struct trace_event *e;
+	struct timespec ts;
+
+	if (!trace_enabled)
+		return;
+
+	e = trace_buf + (__atomic_fetch_add(&trace_head, 1, __ATOMIC_RELAXED) &
+			 (TRACE_BUFFER_SIZE - 1));
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	e->virt_us = get_time().val;
+	e->wall_us = ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+	e->flow = flow;
+	e->event = event;
+	e->type = type;
+	e->task = in_interrupt ? TRACE_TID_ISR : task;
+	e->target = target;
+}
+
+static const char *trace_task_name(int tid)
+{
+	if (tid < TASK_ID_COUNT)
+		return task_names[tid];
+	if (tid == TRACE_TID_ISR)
+		return "<< interrupt >>";
+	if (tid == TASK_ID_INT_GEN)
+		return "<< interrupt generator >>";
+	return "<< unknown >>";
+}
+
+void emulator_trace_enable(const char *path)
+{
+	trace_buf = calloc(TRACE_BUFFER_SIZE, sizeof(*trace_buf));
+	if (!trace_buf) {
+		fprintf(stderr, "Can't allocate trace buffer\n");
+		return;
+	}
+	trace_path = path;
+	trace_enabled = 1;
+	atexit(emulator_trace_dump);
+}
+
+void emulator_trace_dump(void)
+{
+	/* Start of the slice running on each track, in virtual time */
+	uint64_t slice_start[TRACE_TID_ISR + 1];
+	uint32_t head, i;
+	FILE *f;
+	int tid;
+
+	if (!trace_enabled)
+		return;
+	trace_enabled = 0;
+
+	f = fopen(trace_path, "w");
+	if (!f) {
+		fprintf(stderr, "Can't write trace to %s\n", trace_path);
+		return;
+	}
+
+	fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	for (tid = 0; tid <= TRACE_TID_ISR; tid++) {
+		slice_start[tid] = ~0ull;
+		fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+			"\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+			tid, trace_task_name(tid));
+		fprintf(f, "{\"name\":\"thread_sort_index\",\"ph\":\"M\","
+			"\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}},\n",
+			tid, -tid);
+	}
+
+	/* Events may have been overwritten by newer ones */
+	head = __atomic_load_n(&trace_head, __ATOMIC_ACQUIRE);
+	i = head > TRACE_BUFFER_SIZE ? head - TRACE_BUFFER_SIZE : 0;
+	for (; i < head; i++) {
+		const struct trace_event *e =
+			trace_buf + (i & (TRACE_BUFFER_SIZE - 1));
+		int t = e->task;
+
+		/* Only tasks and interrupts have slices */
+		if (t > TRACE_TID_ISR && e->type != TRACE_SET_EVENT)
+			continue;
+
+		switch (e->type) {
+		case TRACE_RESUME:
+		case TRACE_ISR_ENTER:
+			slice_start[t] = e->virt_us;
+			if (e->flow)
+				fprintf(f, "{\"name\":\"wake\",\"cat\":\"wake\","
+					"\"ph\":\"f\",\"bp\":\"e\",\"id\":%u,"
+					"\"pid\":1,\"tid\":%d,\"ts\":%" PRIu64
+					"},\n", e->flow, t, e->virt_us);
+			break;
+		case TRACE_SUSPEND:
+		case TRACE_ISR_EXIT:
+			/* The start of this slice was lost to wrap-around */
+			if (slice_start[t] == ~0ull)
+				break;
+			fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+				"\"tid\":%d,\"ts\":%" PRIu64 ",\"dur\":%" PRIu64
+				",\"args\":{\"wall_us\":%" PRIu64 "}},\n",
+				e->type == TRACE_ISR_EXIT ? "isr" : "run", t,
+				slice_start[t], e->virt_us - slice_start[t],
+				e->wall_us);
+			slice_start[t] = ~0ull;
+			break;
+		case TRACE_SET_EVENT:
+			fprintf(f, "{\"name\":\"set_event\",\"ph\":\"i\","
+				"\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%" PRIu64
+				",\"args\":{\"target\":\"%s\",\"event\":"
+				"\"0x%08x\",\"wall_us\":%" PRIu64 "}},\n",
+				t, e->virt_us, trace_task_name(e->target),
+				e->event, e->wall_us);
+			fprintf(f, "{\"name\":\"wake\",\"cat\":\"wake\","
+				"\"ph\":\"s\",\"id\":%u,\"pid\":1,\"tid\":%d,"
+				"\"ts\":%" PRIu64 "},\n", e->flow, t, e->virt_us);
+			break;
+		}
+	}
+
+	/* Close the array with an event, since JSON has no trailing commas */
+	fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+		"\"args\":{\"name\":\"%s\"}}\n]}\n", __get_prog_name());
+	fclose(f);
+}
+
 void task_pre_init(void)
 {
 	/* Nothing */
 }
 
+/*
+ * Wait on a semaphore, retrying if interrupted by SIGNAL_INTERRUPT being
+ * delivered to this thread.
+ */
+static void wait_sem(sem_t *sem)
+{
+	while (sem_wait(sem) && errno == EINTR)
+		;
+}
+
+static inline int wake_heap_before(int a, int b)
+{
+	return tasks[wake_heap[a]].wake_time.val <
+	       tasks[wake_heap[b]].wake_time.val;
+}
+
+static void wake_heap_swap(int a, int b)
+{
+	task_id_t t = wake_heap[a];
+
+	wake_heap[a] = wake_heap[b];
+	wake_heap[b] = t;
+	tasks[wake_heap[a]].heap_index = a;
+	tasks[wake_heap[b]].heap_index = b;
+}
+
+/* Restore heap order for the entry at index i, moving it up or down. */
+static void wake_heap_fix(int i)
+{
+	int child;
+
+	while (i > 0 && wake_heap_before(i, (i - 1) / 2)) {
+		wake_heap_swap(i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+
+	while ((child = 2 * i + 1) < wake_heap_size) {
+		if (child + 1 < wake_heap_size &&
+		    wake_heap_before(child + 1, child))
+			child++;
+		if (!wake_heap_before(child, i))
+			break;
+		wake_heap_swap(i, child);
+		i = child;
+	}
+}
+
+/* Queue the task, or requeue it if its wake time has changed. */
+static void wake_heap_update(task_id_t tskid)
+{
+	int i = tasks[tskid].heap_index;
+
+	if (i < 0) {
+		i = wake_heap_size++;
+		wake_heap[i] = tskid;
+		tasks[tskid].heap_index = i;
+	}
+	wake_heap_fix(i);
+}
+
+static void wake_heap_remove(task_id_t tskid)
+{
+	int i = tasks[tskid].heap_index;
+
+	if (i < 0)
+		return;
+
+	tasks[tskid].heap_index = -1;
+	if (i == --wake_heap_size)
+		return;
+
+	wake_heap[i] = wake_heap[wake_heap_size];
+	tasks[wake_heap[i]].heap_index = i;
+	wake_heap_fix(i);
+}
+
 int in_interrupt_context(void)
 {
 	return !!in_interrupt;
@@ -120,7 +389,9 @@ void interrupt_enable(void)
 static void _task_execute_isr(int sig)
 {
 	in_interrupt = 1;
+	trace_event(TRACE_ISR_ENTER, running_task_id, 0, 0, 0);
 	pending_isr();
+	trace_event(TRACE_ISR_EXIT, running_task_id, 0, 0, 0);
 	sem_post(&interrupt_sem);
 	in_interrupt = 0;
 }
@@ -162,11 +433,32 @@ void interrupt_generator_udelay(unsigned us)
 {
 	generator_sleep_deadline.val = get_time().val + us;
 	generator_sleeping = 1;
+
+	/*
+	 * In virtual time, the clock only moves when the scheduler moves it,
+	 * so wait for the scheduler to wake us at the deadline.
+	 */
+	if (emulator_virtual_time_enabled()) {
+		wait_sem(&generator_sem);
+		return;
+	}
+
 	while (get_time().val < generator_sleep_deadline.val)
 		;
 	generator_sleeping = 0;
 }
 
+/* In virtual time, wake the interrupt generator once its deadline passes */
+static void generator_wake_if_due(void)
+{
+	if (!generator_sleeping || !emulator_virtual_time_enabled() ||
+	    get_time().val < generator_sleep_deadline.val)
+		return;
+
+	generator_sleeping = 0;
+	sem_post(&generator_sem);
+}
+
 const char *task_get_name(task_id_t tskid)
 {
 	return task_names[tskid];
@@ -179,7 +471,17 @@ pthread_t task_get_thread(task_id_t tskid)
 
 uint32_t task_set_event(task_id_t tskid, uint32_t event, int wait)
 {
+	if (trace_enabled && event) {
+		tasks[tskid].trace_flow = trace_new_flow();
+		trace_event(TRACE_SET_EVENT, task_get_current(), tskid, event,
+			    tasks[tskid].trace_flow);
+	}
 	tasks[tskid].event = event;
+	if (event)
+		task_stats_event_set(tskid);
+	/* Publish the event before marking the task ready */
+	if (event)
+		atomic_or(&tasks_ready, 1 << tskid);
 	if (wait)
 		return task_wait_event(-1);
 	return 0;
@@ -190,16 +492,24 @@ uint32_t task_wait_event(int timeout_us)
 	int tid = task_get_current();
 	int ret;
 	pthread_mutex_lock(&interrupt_lock);
-	if (timeout_us > 0)
+	if (timeout_us > 0) {
 		tasks[tid].wake_time.val = get_time().val + timeout_us;
+		wake_heap_update(tid);
+	}
 
 	/* Transfer control to scheduler */
-	pthread_cond_signal(&scheduler_cond);
-	pthread_cond_wait(&tasks[tid].resume, &run_lock);
-
-	/* Resume */
-	ret = tasks[tid].event;
-	tasks[tid].event = 0;
+	trace_event(TRACE_SUSPEND, tid, 0, 0, 0);
+	task_stats_switch(tid, TASK_ID_INVALID);
+	sem_post(&scheduler_sem);
+	wait_sem(&tasks[tid].resume);
+	task_stats_switch(TASK_ID_INVALID, tid);
+	/* Link the resume to the task_set_event() which woke us, if any */
+	trace_event(TRACE_RESUME, tid, 0, 0, tasks[tid].trace_flow);
+	tasks[tid].trace_flow = 0;
+
+	/* Resume; leave the ready set before consuming the events */
+	atomic_clear(&tasks_ready, 1 << tid);
+	ret = atomic_read_clear(&tasks[tid].event);
 	pthread_mutex_unlock(&interrupt_lock);
 	return ret;
 }
@@ -226,8 +536,11 @@ uint32_t task_wait_event_mask(uint32_t event_mask, int timeout_us)
 	}
 
 	/* Re-post any other events collected */
-	if (events & ~event_mask)
-		tasks[task_get_current()].event |= events & ~event_mask;
+	if (events & ~event_mask) {
+		atomic_or(&tasks[task_get_current()].event,
+			  events & ~event_mask);
+		atomic_or(&tasks_ready, 1 << task_get_current());
+	}
 
 	return events & event_mask;
 }
@@ -297,19 +610,10 @@ void wait_for_task_started(void)
 
 static task_id_t task_get_next_wake(void)
 {
-	int i;
-	timestamp_t min_time;
-	int which_task = TASK_ID_INVALID;
-
-	min_time.val = ~0ull;
-
-	for (i = TASK_ID_COUNT - 1; i >= 0; --i)
-		if (min_time.val >= tasks[i].wake_time.val) {
-			min_time.val = tasks[i].wake_time.val;
-			which_task = i;
-		}
+	if (!wake_heap_size)
+		return TASK_ID_INVALID;
 
-	return which_task;
+	return wake_heap[0];
 }
 
 static int fast_forward(void)
@@ -345,6 +649,7 @@ static int fast_forward(void)
 		return task_id;
 	} else {
 		force_time(generator_sleep_deadline);
+		generator_wake_if_due();
 		return TASK_ID_IDLE;
 	}
 }
@@ -354,36 +659,64 @@ int task_start_called(void)
 	return task_started;
 }
 
+/*
+ * Return the highest priority task which has a pending event or whose wake
+ * time has passed, or TASK_ID_INVALID if there is none.
+ */
+static task_id_t task_get_next_ready(void)
+{
+	timestamp_t now = get_time();
+	uint32_t ready;
+	task_id_t i;
+
+	/* Move every expired wake time to the timed out set */
+	while (wake_heap_size &&
+	       now.val >= tasks[wake_heap[0]].wake_time.val) {
+		tasks_timed_out |= 1 << wake_heap[0];
+		wake_heap_remove(wake_heap[0]);
+	}
+
+	while (1) {
+		/* Only tasks with spawned threads are valid to be resumed. */
+		ready = (tasks_ready | tasks_timed_out) & tasks_spawned;
+		if (!ready)
+			return TASK_ID_INVALID;
+
+		i = 31 - __builtin_clz(ready);
+		if (tasks[i].event || (tasks_timed_out & (1 << i)))
+			return i;
+
+		/*
+		 * The task consumed its events after they were flagged.  Drop
+		 * the stale ready bit, unless a new event raced in.
+		 */
+		atomic_clear(&tasks_ready, 1 << i);
+		if (tasks[i].event)
+			atomic_or(&tasks_ready, 1 << i);
+	}
+}
+
 void task_scheduler(void)
 {
 	int i;
-	timestamp_t now;
 
 	task_started = 1;
 
 	while (1) {
-		now = get_time();
-		i = TASK_ID_COUNT - 1;
-		while (i >= 0) {
-			/*
-			 * Only tasks with spawned threads are valid to be
-			 * resumed.
-			 */
-			if (tasks[i].thread) {
-				if (tasks[i].event ||
-				    now.val >= tasks[i].wake_time.val)
-					break;
-			}
-			--i;
-		}
-		if (i < 0)
+		/* Time may have moved on while the last task ran */
+		generator_wake_if_due();
+
+		i = task_get_next_ready();
+		if (i == TASK_ID_INVALID)
 			i = fast_forward();
 
+		wake_heap_remove(i);
+		tasks_timed_out &= ~(1 << i);
 		tasks[i].wake_time.val = ~0ull;
 		running_task_id = i;
 		tasks[i].started = 1;
-		pthread_cond_signal(&tasks[i].resume);
-		pthread_cond_wait(&scheduler_cond, &run_lock);
+		sem_post(&tasks[i].resume);
+		wait_sem(&scheduler_sem);
 	}
 }
 
@@ -392,10 +725,10 @@ void *_task_start_impl(void *a)
 	long tid = (long)a;
 	struct task_args *arg = task_info + tid;
 	my_task_id = tid;
-	pthread_mutex_lock(&run_lock);
 
 	/* Wait for scheduler */
 	task_wait_event(1);
+	atomic_clear(&tasks_ready, 1 << tid);
 	tasks[tid].event = 0;
 
 	/* Start the task routine */
@@ -418,27 +751,32 @@ void *_task_int_generator_start(void *d)
 	return NULL;
 }
 
+static void task_spawn(task_id_t tskid)
+{
+	tasks[tskid].wake_time.val = ~0ull;
+	tasks[tskid].heap_index = -1;
+	tasks[tskid].started = 0;
+	sem_init(&tasks[tskid].resume, 0, 0);
+	task_set_event(tskid, TASK_EVENT_WAKE, 0);
+	pthread_create(&tasks[tskid].thread, NULL, _task_start_impl,
+		       (void *)(uintptr_t)tskid);
+	atomic_or(&tasks_spawned, 1 << tskid);
+}
+
 int task_start(void)
 {
 	int i = TASK_ID_HOOKS;
 
-	pthread_mutex_init(&run_lock, NULL);
 	pthread_mutex_init(&interrupt_lock, NULL);
-	pthread_cond_init(&scheduler_cond, NULL);
-
-	pthread_mutex_lock(&run_lock);
+	sem_init(&scheduler_sem, 0, 0);
+	sem_init(&generator_sem, 0, 0);
 
 	/*
 	 * Initialize the hooks task first.  After its init, it will callback to
 	 * enable the remaining tasks.
 	 */
-	tasks[i].event = TASK_EVENT_WAKE;
-	tasks[i].wake_time.val = ~0ull;
-	tasks[i].started = 0;
-	pthread_cond_init(&tasks[i].resume, NULL);
-	pthread_create(&tasks[i].thread, NULL, _task_start_impl,
-		       (void *)(uintptr_t)i);
-	pthread_cond_wait(&scheduler_cond, &run_lock);
+	task_spawn(i);
+	wait_sem(&scheduler_sem);
 	/*
 	 * Interrupt lock is grabbed by the task which just started.
 	 * Let's unlock it so the next task can be started.
@@ -458,8 +796,8 @@ int task_start(void)
 	 * Tell the hooks task to continue so that it can call back to enable
 	 * the other tasks.
 	 */
-	pthread_cond_signal(&tasks[i].resume);
-	pthread_cond_wait(&scheduler_cond, &run_lock);
+	sem_post(&tasks[i].resume);
+	wait_sem(&scheduler_sem);
 	task_enable_all_tasks_callback();
 
 	task_scheduler();
@@ -476,24 +814,22 @@ static void task_enable_all_tasks_callback(void)
 		if (tasks[i].thread != (pthread_t)NULL)
 			continue;
 
-		tasks[i].event = TASK_EVENT_WAKE;
-		tasks[i].wake_time.val = ~0ull;
-		tasks[i].started = 0;
-		pthread_cond_init(&tasks[i].resume, NULL);
-		pthread_create(&tasks[i].thread, NULL, _task_start_impl,
-			       (void *)(uintptr_t)i);
+		task_spawn(i);
 		/*
 		 * Interrupt lock is grabbed by the task which just started.
 		 * Let's unlock it so the next task can be started.
 		 */
 		pthread_mutex_unlock(&interrupt_lock);
-		pthread_cond_wait(&scheduler_cond, &run_lock);
+		wait_sem(&scheduler_sem);
 	}
 
 }
 
 void task_enable_all_tasks(void)
 {
-	/* Signal to the scheduler to enable the remaining tasks. */
-	pthread_cond_signal(&scheduler_cond);
+	/*
+	 * Nothing to do.  The scheduler enables the remaining tasks as soon
+	 * as the hooks task yields for the first time; posting the scheduler
+	 * here would let it run concurrently with the hooks task.
+	 */
 }
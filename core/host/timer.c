@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <time.h>
 
+#include "console.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -37,6 +38,29 @@
 static timestamp_t boot_time;
 static int time_set;
 
+/*
+ * In virtual time mode, emulator time only advances through force_time()
+ * jumps, which the scheduler makes whenever all tasks are idle.  Nothing
+ * waits on the wall clock, so a test runs as fast as the host allows.  Tests
+ * opt in by specifying <test_name>-virtual-time=y in test/build.mk, or at run
+ * time with the --virtual-time flag.
+ */
+#ifdef TEST_VIRTUAL_TIME
+static int virtual_time = 1;
+#else
+static int virtual_time;
+#endif
+
+/* Wall clock at emulator start, in microseconds */
+static uint64_t wall_boot_time;
+
+uint64_t get_wall_time_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return 1000000 * (uint64_t)ts.tv_sec + ts.tv_nsec / 1000;
+}
+
 void usleep(unsigned us)
 {
 	if (!task_start_called()) {
@@ -54,6 +78,13 @@ timestamp_t _get_time(void)
 {
 	struct timespec ts;
 	timestamp_t ret;
+
+	/* The virtual clock stands still; get_time() is set by force_time() */
+	if (virtual_time) {
+		ret.val = 0;
+		return ret;
+	}
+
 	clock_gettime(CLOCK_MONOTONIC, &ts);
 	ret.val = (1000000000 * (uint64_t)ts.tv_sec + ts.tv_nsec) *
 		  TEST_TIME_SCALE / 1000 / TEST_TIME_SLOW_DOWN;
@@ -84,6 +115,11 @@ void udelay(unsigned us)
 	}
 
 	deadline.val = get_time().val + us;
+	if (virtual_time) {
+		force_time(deadline);
+		return;
+	}
+
 	while (get_time().val < deadline.val)
 		;
 }
@@ -102,6 +138,26 @@ int timestamp_expired(timestamp_t deadline, const timestamp_t *now)
 
 void timer_init(void)
 {
+	wall_boot_time = get_wall_time_us();
 	if (!time_set)
 		boot_time = _get_time();
 }
+
+void emulator_set_virtual_time(int enabled)
+{
+	virtual_time = enabled;
+}
+
+int emulator_virtual_time_enabled(void)
+{
+	return virtual_time;
+}
+
+void emulator_print_time_report(void)
+{
+	uint64_t sim = get_time().val;
+	uint64_t wall = get_wall_time_us() - wall_boot_time;
+
+	ccprintf("Simulated time: %.6ld s, wall time: %.6ld s (%s time)\n",
+		 sim, wall, virtual_time ? "virtual" : "real");
+}
@@ -547,6 +547,16 @@
 /* Max length of a single line of input */
 #define CONFIG_CONSOLE_INPUT_LINE_SIZE 80
 
+/*
+ * Store cprintf() and cprints() output as binary records of format string,
+ * time and raw arguments, and format it later in the console task or on the
+ * host.  Output on the command channel is still printed directly.
+ */
+#undef CONFIG_CONSOLE_BINLOG
+
+/* Size of the binary log in bytes; must be a power of two */
+#define CONFIG_CONSOLE_BINLOG_SIZE 1024
+
 /*
  * Disable EC console input if the system is locked.  This is needed for
  * security on platforms where the EC console is accessible from outside the
@@ -854,6 +864,9 @@
  */
 #undef CONFIG_HOST_COMMAND_STATUS
 
+/* Support EC_CMD_BATCH, to run several host commands from one request */
+#undef CONFIG_HOSTCMD_BATCH
+
 /* If we have host command task, assume we also are using host events. */
 #ifdef HAS_TASK_HOSTCMD
 #define CONFIG_HOSTCMD_EVENTS
@@ -884,6 +897,13 @@
 #define CONFIG_HOSTCMD_RATE_LIMITING_MIN_REST (3   * MSEC)
 #define CONFIG_HOSTCMD_RATE_LIMITING_RECESS   (20  * MSEC)
 
+/*
+ * Keep per-command call counts, error counts and handler run times, readable
+ * with the hcstats console command and EC_CMD_HOST_COMMAND_STATS.  Costs two
+ * timer reads per host command.
+ */
+#undef CONFIG_HOSTCMD_STATS
+
 /* PD MCU supports host commands */
 #undef CONFIG_HOSTCMD_PD
 
@@ -1323,10 +1343,10 @@
 /* Support IR357x Link voltage regulator debugging / reprogramming */
 #undef CONFIG_REGULATOR_IR357X
 
-/* Support verifying 2048-bit RSA signature */
+/* Support verifying RSA signatures */
 #undef CONFIG_RSA
 
-/* Define the RSA key size. */
+/* Define the RSA key size: 2048 (default), 3072, 4096 or 8192 bits. */
 #undef CONFIG_RSA_KEY_SIZE
 
 /* Flash address of the RO image. */
@@ -1374,6 +1394,13 @@
 /* Support computing SHA-256 hash (without the VBOOT code) */
 #undef CONFIG_SHA256
 
+/*
+ * Unroll the SHA-256 rounds, at the cost of a bigger image.  Whether this
+ * hashes any faster depends on the core; on the emulator it makes no
+ * measurable difference.  Measure with test/sha256_bench.c before enabling.
+ */
+#undef CONFIG_SHA256_UNROLLED
+
 /* Emulate the CLZ (Count Leading Zeros) in software for CPU lacking support */
 #undef CONFIG_SOFTWARE_CLZ
 
@@ -1478,6 +1505,13 @@
  */
 #define CONFIG_TASK_PROFILING
 
+/*
+ * Keep per-task histograms of wake-up latency and run time, readable with
+ * the taskstats console command and EC_CMD_TASK_STATS.  Costs a timer read
+ * on every context switch and event.  Not supported on nds32.
+ */
+#undef CONFIG_TASK_STATS
+
 /*****************************************************************************/
 /* Temperature sensor config */
 
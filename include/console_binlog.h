@@ -0,0 +1,75 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Binary console log for Chrome EC */
+
+#ifndef __CROS_EC_CONSOLE_BINLOG_H
+#define __CROS_EC_CONSOLE_BINLOG_H
+
+#include <stdarg.h>
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+
+enum console_binlog_mode {
+	/* Print all output directly */
+	CONSOLE_BINLOG_OFF = 0,
+	/* Record output, and print it from the console task */
+	CONSOLE_BINLOG_DEFER,
+	/* Record output for the host to read; don't print it at all */
+	CONSOLE_BINLOG_HOST,
+};
+
+/**
+ * Set the binary log mode.
+ */
+void console_binlog_set_mode(enum console_binlog_mode mode);
+
+/**
+ * Record formatted output in the binary log.
+ *
+ * @param channel	Output channel
+ * @param flags		Record flags (EC_BINLOG_FLAG_*)
+ * @param format	Format string; must stay valid until the record has
+ *			been printed, so in practice a string literal
+ * @param args		Parameters
+ * @return 1 if the output was recorded, or 0 if the caller should print it
+ *	   directly; because the log is off for the channel, or the record
+ *	   would be too big.  In defer mode, records which haven't been
+ *	   printed yet are printed before returning 0, unless called from an
+ *	   interrupt.
+ */
+int console_binlog_vprintf(enum console_channel channel, int flags,
+			   const char *format, va_list args);
+
+/**
+ * Record a string in the binary log.
+ *
+ * @return 1 if the string was recorded, or 0 if the caller should print it.
+ */
+int console_binlog_puts(enum console_channel channel, const char *outstr);
+
+/**
+ * Format a record from the binary log.
+ *
+ * @param record	Record to format
+ * @param addstr	Output function; see vfnprintf_str()
+ * @param context	Context for addstr()
+ * @return EC_SUCCESS, or non-zero if output was truncated.
+ */
+int console_binlog_format(const uint32_t *record,
+			  int (*addstr)(void *context, const char *str,
+					int len),
+			  void *context);
+
+/**
+ * Print records which haven't been printed yet.
+ *
+ * Called from the console task.
+ */
+void console_binlog_flush(void);
+
+#endif  /* __CROS_EC_CONSOLE_BINLOG_H */
@@ -67,7 +67,9 @@
 #define EC_MEMMAP_SWITCHES_VERSION 0x25 /* Version of data in 0x30 - 0x33 */
 #define EC_MEMMAP_EVENTS_VERSION   0x26 /* Version of data in 0x34 - 0x3f */
 #define EC_MEMMAP_HOST_CMD_FLAGS   0x27 /* Host cmd interface flags (8 bits) */
-/* Unused 0x28 - 0x2f */
+#define EC_MEMMAP_UPDATE_SEQ       0x28 /* Update sequence number (8 bits) */
+#define EC_MEMMAP_UPDATE_BUSY      0x29 /* Updates in progress (8 bits) */
+/* Unused 0x2a - 0x2f */
 #define EC_MEMMAP_SWITCHES         0x30	/* 8 bits */
 /* Unused 0x31 - 0x33 */
 #define EC_MEMMAP_HOST_EVENTS      0x34 /* 32 bits */
@@ -104,6 +106,15 @@
  */
 #define EC_MEMMAP_NO_ACPI 0xe0
 
+/*
+ * The EC increments EC_MEMMAP_UPDATE_SEQ at the start and at the end of each
+ * update to data which spans several fields, and holds EC_MEMMAP_UPDATE_BUSY
+ * non-zero while it's updating.  A host reading the memory map directly gets
+ * a consistent view by reading the sequence number, checking the busy count
+ * is zero, reading the data, and checking the sequence number hasn't
+ * changed.  Valid only if EC_MEMMAP_ID_VERSION returns >= 2.
+ */
+
 /* Define the format of the accelerometer mapped memory status byte. */
 #define EC_MEMMAP_ACC_STATUS_SAMPLE_ID_MASK  0x0f
 #define EC_MEMMAP_ACC_STATUS_BUSY_BIT        (1 << 4)
@@ -766,6 +777,40 @@ struct ec_params_read_memmap {
 	uint8_t size;     /* Size to read in bytes */
 } __packed;
 
+/*
+ * Read a consistent snapshot of memory-mapped data.
+ *
+ * The EC retries internally until it has copied the data without an update
+ * happening in the meantime.  With EC_MEMMAP_SNAPSHOT_IF_CHANGED, data is
+ * only returned if the sequence number differs from params.seq, so a host
+ * polling the memory map only transfers data when something changed.
+ *
+ * Response is struct ec_response_memmap_snapshot, followed by params.size
+ * bytes of data unless EC_MEMMAP_SNAPSHOT_UNCHANGED is set.  Returns
+ * EC_RES_BUSY if the data kept changing.
+ */
+#define EC_CMD_MEMMAP_SNAPSHOT 0xa5
+
+/* Only return data if the sequence number isn't params.seq */
+#define EC_MEMMAP_SNAPSHOT_IF_CHANGED (1 << 0)
+
+struct ec_params_memmap_snapshot {
+	uint8_t offset;		/* Offset in memmap (EC_MEMMAP_*) */
+	uint8_t size;		/* Size to read in bytes */
+	uint8_t flags;		/* See EC_MEMMAP_SNAPSHOT_IF_CHANGED */
+	uint8_t seq;		/* Sequence number of the last snapshot */
+} __packed;
+
+/* Nothing changed since params.seq; no data follows */
+#define EC_MEMMAP_SNAPSHOT_UNCHANGED (1 << 0)
+
+struct ec_response_memmap_snapshot {
+	uint8_t seq;		/* Sequence number of this snapshot */
+	uint8_t flags;		/* See EC_MEMMAP_SNAPSHOT_UNCHANGED */
+	uint8_t reserved[2];
+	uint8_t data[0];
+} __packed;
+
 /* Read versions supported for a command */
 #define EC_CMD_GET_CMD_VERSIONS 0x08
 
@@ -950,6 +995,105 @@ struct ec_response_get_features {
 	uint32_t flags[2];
 } __packed;
 
+/*****************************************************************************/
+/* Task scheduling statistics */
+#define EC_CMD_TASK_STATS 0x0e
+
+/*
+ * Histograms have log2 buckets, in microseconds.  Bucket 0 counts samples
+ * under 1 us, bucket n counts samples in [2^(n-1), 2^n) us, and the last
+ * bucket counts everything from 2^(EC_TASK_STATS_BUCKETS - 2) us up.
+ */
+#define EC_TASK_STATS_BUCKETS 16
+
+/* Clear the statistics of all tasks after reading those of this one */
+#define EC_TASK_STATS_FLAG_RESET (1 << 0)
+
+struct ec_params_task_stats {
+	uint8_t task_id;	/* Task to read; 0 is the idle task */
+	uint8_t flags;		/* See EC_TASK_STATS_FLAG_* */
+} __packed;
+
+struct ec_response_task_stats {
+	uint8_t task_count;	/* Number of tasks, including the idle task */
+	uint8_t reserved[3];
+	char name[16];		/* Task name, null-terminated */
+	/* Time between task_set_event() and the task starting to run */
+	uint32_t wake_latency[EC_TASK_STATS_BUCKETS];
+	/* Time the task ran each time it was scheduled */
+	uint32_t run_time[EC_TASK_STATS_BUCKETS];
+} __packed;
+
+/*****************************************************************************/
+/*
+ * Run several commands from one request.
+ *
+ * The params are a struct ec_params_batch, followed by count sub-commands;
+ * each is a struct ec_batch_request, then its params, padded to a multiple of
+ * 4 bytes.  The response is a struct ec_response_batch, followed by a struct
+ * ec_batch_response for each sub-command which was run, then its response
+ * data, padded likewise.
+ *
+ * Sub-commands are run in order, each with its own result.  A failing
+ * sub-command doesn't stop the rest.  Each sub-command is only run if
+ * response_max bytes of response still fit; if not, it and those after it
+ * aren't run, and the response count is less than the request count.  A
+ * sub-command whose response is bigger than its response_max fails with
+ * EC_RES_INVALID_RESPONSE.  Sub-commands may not be batches themselves.
+ */
+#define EC_CMD_BATCH 0x0f
+
+struct ec_params_batch {
+	uint8_t count;		/* Number of sub-commands */
+	uint8_t reserved[3];
+} __packed;
+
+struct ec_batch_request {
+	uint16_t command;
+	uint8_t version;
+	uint8_t reserved;
+	uint16_t size;		/* Size of params which follow */
+	uint16_t response_max;	/* Space for the response */
+} __packed;
+
+struct ec_response_batch {
+	uint8_t count;		/* Number of sub-commands run */
+	uint8_t reserved[3];
+} __packed;
+
+struct ec_batch_response {
+	uint16_t result;	/* enum ec_status */
+	uint16_t size;		/* Size of response which follows */
+} __packed;
+
+/* Sub-command params and responses are padded to this */
+#define EC_BATCH_ALIGN(size) (((size) + 3) & ~3)
+
+/*****************************************************************************/
+/*
+ * Host command statistics.  Commands are read by index into the EC's table
+ * of commands; the response says how many there are.
+ */
+#define EC_CMD_HOST_COMMAND_STATS 0xa4
+
+/* Clear the statistics of all commands after reading those of this one */
+#define EC_HOST_COMMAND_STATS_FLAG_RESET (1 << 0)
+
+struct ec_params_host_command_stats {
+	uint16_t index;		/* Index of the command to read */
+	uint8_t flags;		/* See EC_HOST_COMMAND_STATS_FLAG_* */
+	uint8_t reserved;
+} __packed;
+
+struct ec_response_host_command_stats {
+	uint16_t count;		/* Number of commands */
+	uint16_t command;	/* Command number */
+	uint32_t calls;		/* Times called */
+	uint32_t errors;	/* Times it returned other than EC_RES_SUCCESS */
+	uint32_t max_time;	/* Longest handler run time, in us */
+	uint64_t total_time;	/* Total handler run time, in us */
+} __packed;
+
 /*****************************************************************************/
 /* Flash commands */
 
@@ -2582,7 +2726,8 @@ struct ec_params_charge_control {
  * end of the previous snapshot.
  *
  * The params are only looked at in version >= 1 of this command. Prior
- * versions will just default to CONSOLE_READ_NEXT behavior.
+ * versions will just default to CONSOLE_READ_NEXT behavior.  Version 2 works
+ * differently; see below.
  *
  * Response is null-terminated string.  Empty string, if there is no more
  * remaining output.
@@ -2598,6 +2743,69 @@ struct ec_params_console_read_v1 {
 	uint8_t subcmd; /* enum ec_console_read_subcmd */
 } __packed;
 
+/*
+ * Version 2 doesn't use snapshots.  The cursor counts bytes of console output
+ * since the EC booted, and the response holds the output written since the
+ * cursor, as much as fits and is still in the buffer.  The data is not
+ * null-terminated; its length is the response size less the header.  Read
+ * again from cursor + length to get the output which follows.
+ */
+struct ec_params_console_read_v2 {
+	uint32_t cursor;	/* Where to start reading */
+} __packed;
+
+/* Output after the requested cursor was overwritten before it was read */
+#define EC_CONSOLE_READ_FLAG_OVERRUN (1 << 0)
+
+struct ec_response_console_read_v2 {
+	uint32_t cursor;	/* Where the data starts */
+	uint32_t end;		/* Cursor just past the newest output */
+	uint8_t flags;		/* EC_CONSOLE_READ_FLAG_* */
+	uint8_t reserved[3];
+	uint8_t data[0];
+} __packed;
+
+/*
+ * Read records from the console binary log.  Whole records are returned,
+ * starting with the oldest one at or after the requested offset; keep reading
+ * from the returned next offset until it reaches head.
+ *
+ * Offsets count 32-bit words since the EC booted.  Each record is:
+ *
+ *   word 0     size in words (including this header), channel and flags;
+ *              see EC_BINLOG_* below
+ *   word 1     offset of the format string from format_base, signed
+ *   words 2-3  time the record was made, in us, low word first
+ *   words 4-   arguments, in format string order: one word for each '*' and
+ *              each 32-bit integer, two words (low first) for 'l' integers,
+ *              none for %T.  %s and %h take a word with a byte count and then
+ *              the bytes themselves, padded to a whole word; %s includes the
+ *              terminating null.
+ *
+ * The format strings are not sent; util/binlog_decode.py looks them up in the
+ * EC image.
+ */
+#define EC_CMD_CONSOLE_BINLOG_READ 0xa3
+
+struct ec_params_console_binlog_read {
+	uint32_t offset;	/* Offset to read from */
+} __packed;
+
+struct ec_response_console_binlog_read {
+	uint32_t format_base;	/* Address format string offsets are from */
+	uint32_t next;		/* Offset just past the returned records */
+	uint32_t head;		/* Offset of the end of the log */
+	uint32_t data[0];	/* Records */
+} __packed;
+
+#define EC_BINLOG_SIZE(header)		((header) & 0xff)
+#define EC_BINLOG_CHANNEL(header)	(((header) >> 8) & 0xff)
+#define EC_BINLOG_HEADER(size, channel, flags) \
+	((size) | ((channel) << 8) | (flags))
+/* Record comes from cprints(); print the time before it and a newline after */
+#define EC_BINLOG_FLAG_TIMESTAMP	(1 << 16)
+#define EC_BINLOG_HEADER_WORDS		4
+
 /*****************************************************************************/
 
 /*
@@ -160,11 +160,25 @@ enum hook_type {
 	HOOK_SECOND,
 };
 
+#ifdef CONFIG_HOOK_DEBUG
+/* Run time statistics for one hook routine, in us */
+struct hook_stats {
+	uint32_t last_run_time;
+	uint32_t max_run_time;
+	uint32_t avg_run_time;
+	uint32_t calls;
+};
+#endif
+
 struct hook_data {
 	/* Hook processing routine. */
 	void (*routine)(void);
 	/* Priority; low numbers = higher priority. */
 	int priority;
+#ifdef CONFIG_HOOK_DEBUG
+	/* Run time statistics for this routine */
+	struct hook_stats *stats;
+#endif
 };
 
 /**
@@ -198,6 +212,26 @@ void hook_notify(enum hook_type type);
  */
 int hook_call_deferred(void (*routine)(void), int us);
 
+struct deferred_data {
+	/* Deferred function pointer */
+	void (*routine)(void);
+};
+
+/**
+ * Start a timer to call a deferred routine, given its handle.
+ *
+ * Like hook_call_deferred(), but takes the handle declared by
+ * DECLARE_DEFERRED(), so the routine doesn't need to be looked up.  Prefer
+ * this in code which defers calls often.
+ *
+ * @param data		Handle of the routine; for DECLARE_DEFERRED(foo), this
+ *			is &foo_data.
+ * @param us		Delay in microseconds, as for hook_call_deferred().
+ *
+ * @return non-zero if error.
+ */
+int hook_call_deferred_data(const struct deferred_data *data, int us);
+
 #ifdef CONFIG_COMMON_RUNTIME
 /**
  * Register a hook routine.
@@ -225,17 +259,26 @@ int hook_call_deferred(void (*routine)(void), int us);
  *			unless there's a compelling reason to care about the
  *			order in which hooks are called.
  */
+#ifdef CONFIG_HOOK_DEBUG
+/*
+ * The explicit alignment stops the compiler from padding the larger struct
+ * out to a cache line, which would leave holes in the hook tables.
+ */
+#define DECLARE_HOOK(hooktype, routine, priority)			\
+	static struct hook_stats CONCAT4(__hook_stats_, hooktype, _, routine); \
+	const struct hook_data __keep CONCAT4(__hook_, hooktype, _, routine) \
+	__attribute__((section(".rodata." STRINGIFY(hooktype))))	\
+	__aligned(sizeof(void *))					\
+	     = {routine, priority,					\
+		&CONCAT4(__hook_stats_, hooktype, _, routine)}
+#else
 #define DECLARE_HOOK(hooktype, routine, priority)			\
 	const struct hook_data __keep CONCAT4(__hook_, hooktype, _, routine) \
 	__attribute__((section(".rodata." STRINGIFY(hooktype))))	\
 	     = {routine, priority}
+#endif
 
 
-struct deferred_data {
-	/* Deferred function pointer */
-	void (*routine)(void);
-};
-
 /**
  * Register a deferred function call.
  *
@@ -248,10 +291,12 @@ struct deferred_data {
  * functions are called from the same hook task.  See DECLARE_HOOK() for an
  * example.
  *
+ * The handle to pass to hook_call_deferred_data() is named routine_data.
+ *
  * @param routine	Function pointer, with prototype void routine(void)
  */
 #define DECLARE_DEFERRED(routine)					\
-	const struct deferred_data CONCAT2(__deferred_, routine)	\
+	const struct deferred_data CONCAT2(routine, _data)		\
 	__attribute__((section(".rodata.deferred")))			\
 	     = {routine}
 
@@ -259,7 +304,7 @@ struct deferred_data {
 #define DECLARE_HOOK(t, func, p)				\
 	void CONCAT2(unused_hook_, func)(void) { func(); }
 #define DECLARE_DEFERRED(func)					\
-	void CONCAT2(unused_deferred_, func)(void) { func(); }
+	const struct deferred_data CONCAT2(func, _data) = {func}
 #endif /* CONFIG_COMMON_RUNTIME */
 
 #endif  /* __CROS_EC_HOOKS_H */
@@ -100,6 +100,16 @@ struct host_packet {
 };
 
 /* Host command */
+#ifdef CONFIG_HOSTCMD_STATS
+/* Statistics for one host command; run times are in us */
+struct host_command_stats {
+	uint32_t calls;
+	uint32_t errors;
+	uint32_t max_time;
+	uint64_t total_time;
+};
+#endif
+
 struct host_command {
 	/*
 	 * Handler for the command.  Args points to context for handler.
@@ -110,6 +120,10 @@ struct host_command {
 	int command;
 	/* Mask of supported versions */
 	int version_mask;
+#ifdef CONFIG_HOSTCMD_STATS
+	/* Statistics for this command */
+	struct host_command_stats *stats;
+#endif
 };
 
 /**
@@ -123,6 +137,20 @@ struct host_command {
  */
 uint8_t *host_get_memmap(int offset);
 
+/**
+ * Mark the start of an update to the memory-mapped buffer.
+ *
+ * Bracket updates to data which spans several fields with this and
+ * host_memmap_update_end(), so the host can tell when it has read a torn
+ * copy.  Updates may nest.  Must not be called from interrupt context.
+ */
+void host_memmap_update_begin(void);
+
+/**
+ * Mark the end of an update to the memory-mapped buffer.
+ */
+void host_memmap_update_end(void);
+
 /**
  * Process a host command and return its response
  *
@@ -171,6 +199,47 @@ uint32_t host_get_events(void);
  */
 void host_send_response(struct host_cmd_handler_args *args);
 
+/**
+ * Finish a slow host command in the background.
+ *
+ * Copies the command's params and calls routine() from the hook task, so the
+ * host command task is free to handle other commands in the meantime.  The
+ * host polls EC_CMD_GET_COMMS_STATUS until the command is done, then collects
+ * its result and response with EC_CMD_RESEND_RESPONSE.
+ *
+ * The hook task also runs HOOK_TICK, HOOK_SECOND and deferred calls, so
+ * routine() should do its work in short steps: it returns EC_RES_IN_PROGRESS
+ * to be called again once those have had a chance to run.
+ *
+ * Without CONFIG_HOST_COMMAND_STATUS, or when the command doesn't come from
+ * the host interface (or its params are too big to copy), routine() is simply
+ * called right away, until it's done.
+ *
+ * Usage, from a host command handler:
+ *
+ *	return host_command_async(args, slow_routine);
+ *
+ * @param args		Host command args, as passed to the handler
+ * @param routine	Routine which does a step of the work, and returns
+ *			EC_RES_IN_PROGRESS, or the command result like a host
+ *			command handler
+ * @return EC_RES_IN_PROGRESS if routine() will be called later,
+ *	   EC_RES_BUSY if another command is already in progress, or the
+ *	   result of routine() if it was called right away.
+ */
+int host_command_async(struct host_cmd_handler_args *args,
+		       int (*routine)(struct host_cmd_handler_args *args));
+
+/**
+ * Check whether a command is still running in the background.
+ *
+ * Commands which touch the same hardware as a background command should
+ * return EC_RES_BUSY while this is true, rather than run alongside it.
+ *
+ * @return non-zero if a background command hasn't finished yet.
+ */
+int host_command_async_pending(void);
+
 /**
  * Called by host interface module when a command is received.
  */
@@ -194,10 +263,21 @@ int host_request_expected_size(const struct ec_host_request *r);
 void host_packet_receive(struct host_packet *pkt);
 
 /* Register a host command handler */
+#ifdef CONFIG_HOSTCMD_STATS
+/* Aligned for the same reason as in DECLARE_HOOK() */
+#define DECLARE_HOST_COMMAND(command, routine, version_mask)		\
+	static struct host_command_stats __host_cmd_stats_##command;	\
+	const struct host_command __keep __host_cmd_##command		\
+	__attribute__((section(".rodata.hcmds")))			\
+	__aligned(sizeof(void *))					\
+	     = {routine, command, version_mask,				\
+		&__host_cmd_stats_##command}
+#else
 #define DECLARE_HOST_COMMAND(command, routine, version_mask)		\
 	const struct host_command __keep __host_cmd_##command		\
 	__attribute__((section(".rodata.hcmds")))			\
 	     = {routine, command, version_mask}
+#endif
 
 
 /**
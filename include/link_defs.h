@@ -53,6 +53,9 @@ extern const struct hook_data __hooks_tick_end[];
 extern const struct hook_data __hooks_second[];
 extern const struct hook_data __hooks_second_end[];
 
+/* Hook dispatch order, filled in by hooks.c */
+extern uint8_t __hook_order[];
+
 /* Deferrable functions */
 extern const struct deferred_data __deferred_funcs[];
 extern const struct deferred_data __deferred_funcs_end[];
@@ -67,6 +67,26 @@
 int vfnprintf(int (*addchar)(void *context, int c), void *context,
 	      const char *format, va_list args);
 
+/**
+ * Print formatted output to a function which takes runs of characters.
+ *
+ * Like vfnprintf(), but literal text and each converted field are passed on
+ * in one call instead of a call per character.
+ *
+ * @param addstr	Function to be called for each run of characters.
+ *			Will be passed the same context passed to
+ *			vfnprintf_str(), the characters and their count; the
+ *			characters are not null-terminated.  Should return 0
+ *			if all the characters were accepted or non-zero if any
+ *			were dropped due to overflow.
+ * @param context	Context pointer to pass to addstr()
+ * @param format	Format string (see above for acceptable formats)
+ * @param args		Parameters
+ * @return EC_SUCCESS, or non-zero if output was truncated.
+ */
+int vfnprintf_str(int (*addstr)(void *context, const char *str, int len),
+		  void *context, const char *format, va_list args);
+
 /**
  * Print formatted outut to a string.
  *
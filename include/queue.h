@@ -8,11 +8,19 @@
 #define __CROS_EC_QUEUE_H
 
 #include "common.h"
+#include "util.h"
 
 #include <stddef.h>
 #include <stdint.h>
 
-/* Generic queue container. */
+/*
+ * Generic queue container.
+ *
+ * A queue may be used by one producer and one consumer at the same time (for
+ * example, an interrupt handler adding units and a task removing them)
+ * without any further locking.  More than one producer, or more than one
+ * consumer, must still be serialized by the caller.
+ */
 
 /*
  * Queue policies describe how a queue behaves (who it notifies, in what
@@ -93,6 +101,73 @@ struct queue {
 		.buffer       = (uint8_t *) &((TYPE[SIZE]){}),	\
 	})
 
+/*
+ * Ordered access to the queue head and tail, so that one producer and one
+ * consumer can use a queue at the same time.  Each side reads the other's
+ * index with acquire ordering and publishes its own with release ordering.
+ */
+static inline size_t queue_load_acquire(size_t const volatile *index)
+{
+	return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+static inline void queue_store_release(size_t volatile *index, size_t value)
+{
+	__atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+/*
+ * Construct a static queue whose size and unit type are fixed at compile
+ * time, along with specialized single unit accessors for it:
+ *
+ *   QUEUE_TYPED(rx, 16, uint8_t, queue_policy_null);
+ *
+ * defines "static struct queue const rx" (usable with all of the generic
+ * functions below) plus:
+ *
+ *   size_t rx_add_unit(uint8_t const *src);
+ *   size_t rx_remove_unit(uint8_t *dest);
+ *
+ * which behave like queue_add_unit() and queue_remove_unit(), but wrap the
+ * indices with a constant mask and copy the unit with a plain assignment
+ * instead of going through the struct queue description.  Use these in
+ * interrupt handlers and other latency sensitive paths.  SIZE must be a power
+ * of two.
+ */
+#define QUEUE_TYPED(NAME, SIZE, TYPE, POLICY)				\
+	static struct queue const NAME = QUEUE(SIZE, TYPE, POLICY);	\
+									\
+	static inline size_t NAME##_add_unit(TYPE const *src)		\
+	{								\
+		size_t tail = NAME.state->tail;				\
+									\
+		if (tail - queue_load_acquire(&NAME.state->head) ==	\
+		    (SIZE))						\
+			return 0;					\
+									\
+		((TYPE *)NAME.buffer)[tail & ((SIZE) - 1)] = *src;	\
+		queue_store_release(&NAME.state->tail, tail + 1);	\
+		if (NAME.policy != &queue_policy_null)			\
+			NAME.policy->add(NAME.policy, 1);		\
+		return 1;						\
+	}								\
+									\
+	static inline size_t NAME##_remove_unit(TYPE *dest)		\
+	{								\
+		size_t head = NAME.state->head;				\
+									\
+		if (queue_load_acquire(&NAME.state->tail) == head)	\
+			return 0;					\
+									\
+		*dest = ((TYPE *)NAME.buffer)[head & ((SIZE) - 1)];	\
+		queue_store_release(&NAME.state->head, head + 1);	\
+		if (NAME.policy != &queue_policy_null)			\
+			NAME.policy->remove(NAME.policy, 1);		\
+		return 1;						\
+	}								\
+									\
+	BUILD_ASSERT(POWER_OF_TWO(SIZE))
+
 /* Initialize the queue to empty state. */
 void queue_init(struct queue const *q);
 
@@ -200,6 +275,45 @@ size_t queue_peek_memcpy(struct queue const *q,
 				const void *src,
 				size_t n));
 
+/*
+ * Batched access, for producers and consumers which handle one unit at a time
+ * (for example an interrupt handler draining a hardware FIFO).  Units added
+ * with queue_batch_add_unit() are not visible to the consumer, and the queue
+ * policy is not notified, until queue_batch_commit_add() publishes all of them
+ * at once.  Likewise, units removed with queue_batch_remove_unit() are only
+ * given back to the producer by queue_batch_commit_remove().
+ *
+ * A batch only sees the space (or units) which were available when it was
+ * begun.  The producer must not otherwise add to the queue, nor the consumer
+ * otherwise remove from it, while it has a batch open.
+ */
+struct queue_batch {
+	size_t index; /* queue index of the first unit in the batch */
+	size_t limit; /* units (or space) available when the batch began */
+	size_t count; /* units added or removed so far */
+};
+
+void queue_batch_begin_add(struct queue const *q, struct queue_batch *batch);
+
+/* Add one unit to the batch; return 0 if there is no more space. */
+size_t queue_batch_add_unit(struct queue const *q,
+			    struct queue_batch *batch,
+			    const void *src);
+
+/* Publish the units added to the batch; return the number published. */
+size_t queue_batch_commit_add(struct queue const *q, struct queue_batch *batch);
+
+void queue_batch_begin_remove(struct queue const *q, struct queue_batch *batch);
+
+/* Remove one unit from the batch; return 0 if there are no more units. */
+size_t queue_batch_remove_unit(struct queue const *q,
+			       struct queue_batch *batch,
+			       void *dest);
+
+/* Free the space of the units removed; return the number removed. */
+size_t queue_batch_commit_remove(struct queue const *q,
+				 struct queue_batch *batch);
+
 /*
  * These macros will statically select the queue functions based on the number
  * of units that are to be added or removed if they can.  The single unit add
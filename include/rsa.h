@@ -24,6 +24,8 @@
  */
 #if CONFIG_RSA_KEY_SIZE == 2048
 #define RSA_PUBLIC_KEY_SIZE 528
+#elif CONFIG_RSA_KEY_SIZE == 3072
+#define RSA_PUBLIC_KEY_SIZE 784
 #elif CONFIG_RSA_KEY_SIZE == 4096
 #define RSA_PUBLIC_KEY_SIZE 1040
 #elif CONFIG_RSA_KEY_SIZE == 8192
@@ -158,6 +158,29 @@ void task_end_irq_handler(void *excep_return);
 #define task_start_irq_handler(excep_return)
 #endif
 
+#ifdef CONFIG_TASK_STATS
+/**
+ * Start timing the wake-up latency of a task which was sent an event.
+ *
+ * May be called from interrupt level.
+ */
+void task_stats_event_set(task_id_t tskid);
+
+/**
+ * Account a context switch in the task statistics.
+ *
+ * Must be called by the scheduler, which must not be preempted.
+ *
+ * @param from		Task which stops running, or TASK_ID_INVALID
+ * @param to		Task which starts running, or TASK_ID_INVALID.  If
+ *			this is the same as from, the task keeps running.
+ */
+void task_stats_switch(task_id_t from, task_id_t to);
+#else
+#define task_stats_event_set(tskid)
+#define task_stats_switch(from, to)
+#endif
+
 /**
  * Change the task scheduled to run after returning from the exception.
  *
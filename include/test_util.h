@@ -144,10 +144,60 @@ void interrupt_generator_udelay(unsigned us);
 
 #ifdef EMU_BUILD
 void wait_for_task_started(void);
+
+/*
+ * Enable or disable virtual time. When enabled, emulator time only advances
+ * when all tasks are idle or on udelay(), and never waits on the wall clock.
+ * Must be called before timer_init().
+ */
+void emulator_set_virtual_time(int enabled);
+
+/* Return non-zero if the emulator is running in virtual time */
+int emulator_virtual_time_enabled(void);
+
+/* Print simulated time against wall clock time since emulator start */
+void emulator_print_time_report(void);
+
+/*
+ * Return the host's monotonic clock, in microseconds.  Unlike get_time(),
+ * this isn't affected by virtual time or the test time scale, so it's what
+ * benchmarks time themselves with.
+ */
+uint64_t get_wall_time_us(void);
+
+/*
+ * Start recording task switches, events and interrupts.  The trace is
+ * written to <path> as Chrome trace event JSON by emulator_trace_dump(),
+ * which is called at test end, on reboot and at exit.
+ */
+void emulator_trace_enable(const char *path);
+
+/* Write out the trace, if enabled */
+void emulator_trace_dump(void);
+
+/*
+ * Serve host commands on a Unix socket at <path>, for ectool and other host
+ * tools.  Must be called before the hook task runs HOOK_INIT.
+ */
+void emulator_set_host_socket(const char *path);
 #else
 static inline void wait_for_task_started(void) { }
+static inline void emulator_print_time_report(void) { }
+static inline void emulator_trace_dump(void) { }
 #endif
 
+/**
+ * Print the result of a benchmark, as
+ * "<count> <what> in <elapsed> us: <rate> <unit>/sec".
+ *
+ * @param count		Number of operations timed
+ * @param what		What the operations were
+ * @param unit		Unit to report the rate in
+ * @param elapsed	Time taken, in microseconds
+ */
+void test_print_rate(int count, const char *what, const char *unit,
+		     uint64_t elapsed);
+
 uint32_t prng(uint32_t seed);
 
 uint32_t prng_no_seed(void);
@@ -33,11 +33,13 @@ test-list-$(BOARD_SAMUS_PD)=
 # Emulator tests
 test-list-host=mutex pingpong utils kb_scan kb_mkbp lid_sw power_button hooks
 test-list-host+=thermal flash queue kb_8042 extpwr_gpio console_edit system
-test-list-host+=sbs_charging host_command
+test-list-host+=sbs_charging host_command console_binlog console_read
 test-list-host+=bklight_lid bklight_passthru interrupt timer_dos button
 test-list-host+=math_util sbs_charging_v2 battery_get_params_smart
 test-list-host+=lightbar inductive_charging usb_pd fan charge_manager
-test-list-host+=charge_ramp
+test-list-host+=charge_ramp sched_bench flash_bench printf_bench
+test-list-host+=sha256_bench sha256_unrolled_bench
+test-list-host+=rsa_bench rsa3072_bench rsa4096_bench
 
 battery_get_params_smart-y=battery_get_params_smart.o
 bklight_lid-y=bklight_lid.o
@@ -45,9 +47,12 @@ bklight_passthru-y=bklight_passthru.o
 button-y=button.o
 charge_manager-y=charge_manager.o
 charge_ramp-y+=charge_ramp.o
+console_binlog-y=console_binlog.o
 console_edit-y=console_edit.o
+console_read-y=console_read.o
 extpwr_gpio-y=extpwr_gpio.o
 flash-y=flash.o
+flash_bench-y=flash_bench.o
 hooks-y=hooks.o
 host_command-y=host_command.o
 inductive_charging-y=inductive_charging.o
@@ -63,9 +68,16 @@ mutex-y=mutex.o
 pingpong-y=pingpong.o
 power_button-y=power_button.o
 powerdemo-y=powerdemo.o
+printf_bench-y=printf_bench.o
 queue-y=queue.o
+rsa_bench-y=rsa_bench.o
+rsa3072_bench-y=rsa_bench.o
+rsa4096_bench-y=rsa_bench.o
 sbs_charging-y=sbs_charging.o
 sbs_charging_v2-y=sbs_charging_v2.o
+sched_bench-y=sched_bench.o
+sha256_bench-y=sha256_bench.o
+sha256_unrolled_bench-y=sha256_bench.o
 stress-y=stress.o
 system-y=system.o
 thermal-y=thermal.o
@@ -76,3 +88,13 @@ utils-y=utils.o
 battery_get_params_smart-y=battery_get_params_smart.o
 lightbar-y=lightbar.o
 fan-y=fan.o
+
+# Tests which only need emulator time to advance when all tasks are idle.
+# They run in virtual time and never wait on the wall clock.
+charge_ramp-virtual-time=y
+inductive_charging-virtual-time=y
+lightbar-virtual-time=y
+sbs_charging-virtual-time=y
+sbs_charging_v2-virtual-time=y
+thermal-virtual-time=y
+timer_dos-virtual-time=y
@@ -0,0 +1,301 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for the binary console log.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "console_binlog.h"
+#include "host_command.h"
+#include "printf.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+static struct {
+	struct ec_response_console_binlog_read r;
+	uint32_t data[64];
+} resp;
+static int resp_words;
+
+/* Newest CC_SYSTEM record */
+static uint32_t last[32];
+
+static char out[128];
+static int out_len;
+
+/* Read the log from an offset; returns the number of record words read */
+static int read_log(uint32_t offset)
+{
+	struct ec_params_console_binlog_read p;
+	struct host_cmd_handler_args args;
+
+	p.offset = offset;
+	args.version = 0;
+	args.command = EC_CMD_CONSOLE_BINLOG_READ;
+	args.params = &p;
+	args.params_size = sizeof(p);
+	args.response = &resp;
+	args.response_max = sizeof(resp);
+	args.response_size = 0;
+
+	if (host_command_process(&args) != EC_RES_SUCCESS)
+		return -1;
+
+	resp_words = (args.response_size - sizeof(resp.r)) / sizeof(uint32_t);
+	return resp_words;
+}
+
+static int out_addstr(void *context, const char *str, int len)
+{
+	if (out_len + len >= sizeof(out))
+		return 1;
+	memcpy(out + out_len, str, len);
+	out_len += len;
+	out[out_len] = '\0';
+	return 0;
+}
+
+/*
+ * Read the whole log, and format the newest CC_SYSTEM record into out[].
+ * Other tasks may be logging on other channels at the same time.
+ */
+static int format_last(void)
+{
+	uint32_t offset = 0;
+	int found = 0;
+	int size;
+	int i;
+
+	do {
+		if (read_log(offset) < 0)
+			return EC_ERROR_UNKNOWN;
+		for (i = 0; i < resp_words; i += size) {
+			size = EC_BINLOG_SIZE(resp.r.data[i]);
+			if (EC_BINLOG_CHANNEL(resp.r.data[i]) != CC_SYSTEM)
+				continue;
+			memcpy(last, resp.r.data + i, size * sizeof(uint32_t));
+			found = 1;
+		}
+		offset = resp.r.next;
+	} while (offset != resp.r.head);
+
+	if (!found)
+		return EC_ERROR_UNKNOWN;
+
+	out_len = 0;
+	out[0] = '\0';
+	return console_binlog_format(last, out_addstr, NULL);
+}
+
+/* Record a format through cprintf() and check it formats like snprintf() */
+#define TEST_RECORD(format, ...)					\
+	do {								\
+		char expected[sizeof(out)];				\
+		snprintf(expected, sizeof(expected), format,		\
+			 ##__VA_ARGS__);				\
+		cprintf(CC_SYSTEM, format, ##__VA_ARGS__);		\
+		TEST_ASSERT(format_last() == EC_SUCCESS);		\
+		TEST_ASSERT(out_len == strlen(expected));		\
+		TEST_ASSERT_ARRAY_EQ(out, expected, out_len);		\
+	} while (0)
+
+static int test_formats(void)
+{
+	char stack_str[8] = "stack";
+
+	TEST_RECORD("plain text");
+	TEST_RECORD("%d %u %x %X %b %c", -42, 42, 0xabc, 0xdef, 5, 'z');
+	TEST_RECORD("%ld %lx", -1234567890123ll, 0x123456789abcdefull);
+	TEST_RECORD("[%5d|%-5d|%05x]", 1, 2, 3);
+	TEST_RECORD("[%*d|%-*d]", 4, 1, 3, 2);
+	TEST_RECORD("%.6d %.3ld", 1234567, 5000000000ll);
+	TEST_RECORD("%s %s %s", "abc", (char *)NULL, "");
+	TEST_RECORD("[%6s|%-6s|%.2s|%.*s]", "ab", "cd", "efgh", 3, "ijkl");
+	TEST_RECORD("%.4h %.*h", "\x12\x34\x56\x78", 3, "\xab\xcd\xef");
+	TEST_RECORD("100%% %y");
+
+	/* String arguments are copied, not referenced */
+	cprintf(CC_SYSTEM, "%s", stack_str);
+	strzcpy(stack_str, "gone", sizeof(stack_str));
+	TEST_ASSERT(format_last() == EC_SUCCESS);
+	TEST_ASSERT_ARRAY_EQ(out, "stack", sizeof("stack"));
+
+	return EC_SUCCESS;
+}
+
+static int test_timestamp(void)
+{
+	uint64_t before = get_time().val;
+	uint64_t after, t;
+	char expected[32];
+
+	cprints(CC_SYSTEM, "x=%d", 7);
+	after = get_time().val;
+
+	/* The record holds the time it was made */
+	TEST_ASSERT(format_last() == EC_SUCCESS);
+	TEST_ASSERT(last[0] & EC_BINLOG_FLAG_TIMESTAMP);
+	t = last[2] | ((uint64_t)last[3] << 32);
+	TEST_ASSERT(t >= before && t <= after);
+
+	/* And that's the time printed */
+	snprintf(expected, sizeof(expected), "[%.6ld x=7]\n", t);
+	TEST_ASSERT(out_len == strlen(expected));
+	TEST_ASSERT_ARRAY_EQ(out, expected, out_len);
+
+	return EC_SUCCESS;
+}
+
+static int test_not_recorded(void)
+{
+	char long_str[64];
+
+	cprintf(CC_SYSTEM, "marker");
+
+	/* Command output is printed directly */
+	ccprintf("command output\n");
+	TEST_ASSERT(format_last() == EC_SUCCESS);
+	TEST_ASSERT_ARRAY_EQ(out, "marker", sizeof("marker"));
+
+	/* As is output too big for a record */
+	memset(long_str, 'x', sizeof(long_str) - 1);
+	long_str[sizeof(long_str) - 1] = '\0';
+	cprintf(CC_SYSTEM, "%s\n", long_str);
+	TEST_ASSERT(format_last() == EC_SUCCESS);
+	TEST_ASSERT_ARRAY_EQ(out, "marker", sizeof("marker"));
+
+	/* And everything when the log is off */
+	console_binlog_set_mode(CONSOLE_BINLOG_OFF);
+	cprintf(CC_SYSTEM, "direct\n");
+	console_binlog_set_mode(CONSOLE_BINLOG_HOST);
+	TEST_ASSERT(format_last() == EC_SUCCESS);
+	TEST_ASSERT_ARRAY_EQ(out, "marker", sizeof("marker"));
+
+	return EC_SUCCESS;
+}
+
+static int test_wrap(void)
+{
+	uint32_t offset = 0;
+	int expected = -1;
+	int i, j;
+
+	/* Several times the log size, so the oldest records are dropped */
+	for (i = 0; i < 200; i++)
+		cprintf(CC_SYSTEM, "%d", i);
+
+	/* Read everything back; the newest records must all be there */
+	do {
+		TEST_ASSERT(read_log(offset) >= 0);
+		for (j = 0; j < resp_words;
+		     j += EC_BINLOG_SIZE(resp.r.data[j])) {
+			if (EC_BINLOG_CHANNEL(resp.r.data[j]) != CC_SYSTEM)
+				continue;
+			TEST_ASSERT(EC_BINLOG_SIZE(resp.r.data[j]) ==
+				    EC_BINLOG_HEADER_WORDS + 1);
+			i = resp.r.data[j + EC_BINLOG_HEADER_WORDS];
+			TEST_ASSERT(expected < 0 || i == expected + 1);
+			expected = i;
+		}
+		TEST_ASSERT(resp.r.next != offset || resp_words == 0);
+		offset = resp.r.next;
+	} while (offset != resp.r.head);
+
+	TEST_ASSERT(expected == 199);
+
+	return EC_SUCCESS;
+}
+
+static int test_defer(void)
+{
+	/* Deferred records are printed by the console task, and kept */
+	console_binlog_set_mode(CONSOLE_BINLOG_DEFER);
+	cprints(CC_SYSTEM, "deferred %d", 1);
+	msleep(10);
+	console_binlog_set_mode(CONSOLE_BINLOG_HOST);
+
+	TEST_ASSERT(format_last() == EC_SUCCESS);
+	TEST_ASSERT_ARRAY_EQ(out + out_len - 12, "deferred 1]\n", 12);
+
+	return EC_SUCCESS;
+}
+
+static int test_short_response(void)
+{
+	struct ec_params_console_binlog_read p = { .offset = 0 };
+
+	/* No room for even the response header */
+	TEST_ASSERT(test_send_host_command(EC_CMD_CONSOLE_BINLOG_READ, 0,
+					   &p, sizeof(p), &resp,
+					   sizeof(resp.r) - 1) ==
+		    EC_RES_INVALID_PARAM);
+
+	return EC_SUCCESS;
+}
+
+/* Find str in the captured console output after c; returns NULL if not */
+static const char *find_after(const char *c, const char *str)
+{
+	int len = strlen(str);
+	int left;
+
+	for (left = strlen(c); left >= len; c++, left--) {
+		if (!memcmp(c, str, len))
+			return c + len;
+	}
+	return NULL;
+}
+
+static int test_defer_order(void)
+{
+	char long_str[64];
+	const char *c;
+
+	memset(long_str, 'x', sizeof(long_str) - 1);
+	long_str[sizeof(long_str) - 1] = '\0';
+
+	/* Output printed directly doesn't overtake deferred records */
+	console_binlog_set_mode(CONSOLE_BINLOG_DEFER);
+	test_capture_console(1);
+	cprintf(CC_SYSTEM, "<one>");
+	cprintf(CC_SYSTEM, "<two %s>", long_str);
+	cprintf(CC_SYSTEM, "<three>");
+	cprints(CC_SYSTEM, "<four %s>", long_str);
+	cprintf(CC_SYSTEM, "<five>");
+	ccprintf("<six>");
+	msleep(10);
+	cflush();
+	test_capture_console(0);
+	console_binlog_set_mode(CONSOLE_BINLOG_HOST);
+
+	c = test_get_captured_console();
+	TEST_ASSERT((c = find_after(c, "<one>")) != NULL);
+	TEST_ASSERT((c = find_after(c, "<two x")) != NULL);
+	TEST_ASSERT((c = find_after(c, "<three>")) != NULL);
+	TEST_ASSERT((c = find_after(c, "<four x")) != NULL);
+	TEST_ASSERT((c = find_after(c, "x>]")) != NULL);
+	TEST_ASSERT((c = find_after(c, "<five>")) != NULL);
+	TEST_ASSERT((c = find_after(c, "<six>")) != NULL);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	console_binlog_set_mode(CONSOLE_BINLOG_HOST);
+
+	RUN_TEST(test_formats);
+	RUN_TEST(test_timestamp);
+	RUN_TEST(test_not_recorded);
+	RUN_TEST(test_wrap);
+	RUN_TEST(test_short_response);
+	RUN_TEST(test_defer);
+	RUN_TEST(test_defer_order);
+
+	test_print_result();
+}
@@ -7,12 +7,14 @@
 
 #include "common.h"
 #include "console.h"
+#include "link_defs.h"
 #include "test_util.h"
 #include "timer.h"
 #include "util.h"
 
 static int cmd_1_call_cnt;
 static int cmd_2_call_cnt;
+static int cmd_3_call_cnt;
 
 static int command_test_1(int argc, char **argv)
 {
@@ -28,6 +30,13 @@ static int command_test_2(int argc, char **argv)
 }
 DECLARE_CONSOLE_COMMAND(test2, command_test_2, NULL, NULL, NULL);
 
+static int command_tab_test(int argc, char **argv)
+{
+	cmd_3_call_cnt++;
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(tabtest, command_tab_test, NULL, NULL, NULL);
+
 /*****************************************************************************/
 /* Test utilities */
 
@@ -273,6 +282,40 @@ static int test_output_channel(void)
 	return EC_SUCCESS;
 }
 
+static int test_commands_sorted(void)
+{
+	const struct console_command *cmd;
+
+	/* Lookup relies on the linker sorting the command table */
+	for (cmd = __cmds + 1; cmd < __cmds_end; cmd++)
+		TEST_ASSERT(strcasecmp(cmd[-1].name, cmd->name) < 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_partial_match(void)
+{
+	cmd_1_call_cnt = 0;
+	cmd_2_call_cnt = 0;
+	cmd_3_call_cnt = 0;
+	UART_INJECT("TEST2\n");
+	UART_INJECT("tabt\n");
+	UART_INJECT("test\n");
+	msleep(30);
+	TEST_CHECK(cmd_1_call_cnt == 0 && cmd_2_call_cnt == 1 &&
+		   cmd_3_call_cnt == 1);
+}
+
+static int test_tab_complete(void)
+{
+	cmd_1_call_cnt = 0;
+	cmd_3_call_cnt = 0;
+	UART_INJECT("tab\t\n");
+	UART_INJECT("test\t1\n");
+	msleep(30);
+	TEST_CHECK(cmd_1_call_cnt == 1 && cmd_3_call_cnt == 1);
+}
+
 void run_test(void)
 {
 	test_reset();
@@ -290,6 +333,9 @@ void run_test(void)
 	RUN_TEST(test_history_stash);
 	RUN_TEST(test_history_list);
 	RUN_TEST(test_output_channel);
+	RUN_TEST(test_commands_sorted);
+	RUN_TEST(test_partial_match);
+	RUN_TEST(test_tab_complete);
 
 	test_print_result();
 }
@@ -0,0 +1,136 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for reading console output with a cursor.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "host_command.h"
+#include "printf.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+static struct {
+	struct ec_response_console_read_v2 r;
+	char data[CONFIG_UART_TX_BUF_SIZE];
+} resp;
+
+/* Read from a cursor; returns the number of bytes read */
+static int read_console(uint32_t cursor, int max_data)
+{
+	struct ec_params_console_read_v2 p;
+	struct host_cmd_handler_args args;
+
+	p.cursor = cursor;
+	args.version = 2;
+	args.command = EC_CMD_CONSOLE_READ;
+	args.params = &p;
+	args.params_size = sizeof(p);
+	args.response = &resp;
+	args.response_max = sizeof(resp.r) + max_data;
+	args.response_size = 0;
+
+	if (host_command_process(&args) != EC_RES_SUCCESS)
+		return -1;
+
+	return args.response_size - sizeof(resp.r);
+}
+
+static uint32_t console_end(void)
+{
+	read_console(0, 0);
+	return resp.r.end;
+}
+
+static int test_read_new_output(void)
+{
+	static const char expected[] = "hello cursor\r\n";
+	uint32_t cursor = console_end();
+	int len;
+
+	ccprintf("hello cursor\n");
+
+	len = read_console(cursor, sizeof(resp.data));
+	TEST_ASSERT(len == sizeof(expected) - 1);
+	TEST_ASSERT(resp.r.cursor == cursor);
+	TEST_ASSERT(resp.r.end == cursor + len);
+	TEST_ASSERT(resp.r.flags == 0);
+	TEST_ASSERT_ARRAY_EQ(resp.data, expected, len);
+
+	/* Nothing more to read */
+	TEST_ASSERT(read_console(cursor + len, sizeof(resp.data)) == 0);
+	TEST_ASSERT(resp.r.flags == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_read_in_pieces(void)
+{
+	static const char expected[] = "0123456789abcdefghij\r\n";
+	char buf[sizeof(expected)];
+	uint32_t cursor = console_end();
+	int total = 0;
+	int len;
+
+	ccprintf("0123456789abcdefghij\n");
+
+	while ((len = read_console(cursor, 3)) > 0) {
+		TEST_ASSERT(len <= 3);
+		TEST_ASSERT(resp.r.flags == 0);
+		TEST_ASSERT(total + len < sizeof(buf));
+		memcpy(buf + total, resp.data, len);
+		total += len;
+		cursor += len;
+	}
+	TEST_ASSERT(total == sizeof(expected) - 1);
+	TEST_ASSERT_ARRAY_EQ(buf, expected, total);
+
+	return EC_SUCCESS;
+}
+
+static int test_overrun(void)
+{
+	uint32_t cursor = console_end();
+	char last[18];
+	int i;
+
+	/* Lines of 17 characters, to more than fill the buffer */
+	for (i = 0; i < CONFIG_UART_TX_BUF_SIZE / 16 + 1; i++) {
+		ccprintf("overrun %7d\n", i);
+		cflush();
+	}
+
+	/* The oldest output is gone */
+	TEST_ASSERT(read_console(cursor, sizeof(resp.data)) ==
+		    CONFIG_UART_TX_BUF_SIZE - 1);
+	TEST_ASSERT(resp.r.flags & EC_CONSOLE_READ_FLAG_OVERRUN);
+	TEST_ASSERT(resp.r.cursor == resp.r.end - (CONFIG_UART_TX_BUF_SIZE - 1));
+	snprintf(last, sizeof(last), "overrun %7d\r\n", i - 1);
+	TEST_ASSERT_ARRAY_EQ(resp.data + CONFIG_UART_TX_BUF_SIZE - 1 - 17,
+			     last, 17);
+
+	/* As is output from a cursor which hasn't been reached yet */
+	cursor = console_end();
+	read_console(cursor + 100, sizeof(resp.data));
+	TEST_ASSERT(resp.r.flags & EC_CONSOLE_READ_FLAG_OVERRUN);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	/* Host commands would otherwise print to the console being read */
+	UART_INJECT("hcdebug off\n");
+	msleep(30);
+
+	RUN_TEST(test_read_new_output);
+	RUN_TEST(test_read_in_pieces);
+	RUN_TEST(test_overrun);
+
+	test_print_result();
+}
@@ -0,0 +1,80 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Emulated flash stress test, reporting writes and erases per second.
+ *
+ * For comparison, when every write or erase rewrote the whole flash array
+ * to the persistent storage file, this test gave about 5,000-6,000 writes
+ * and erases per second.  That was measured on an x86-64 Linux host
+ * with ext4 storage, by building it against chip/host/flash.c from before
+ * the flash was mapped onto its storage file.  Mapped, the same host does
+ * about 2,000,000 writes and 2,500,000 erases per second.
+ */
+#include "common.h"
+#include "console.h"
+#include "flash.h"
+#include "test_util.h"
+#include "util.h"
+
+#define OP_COUNT 10000
+
+static int test_write_rate(void)
+{
+	char buf[CONFIG_FLASH_WRITE_IDEAL_SIZE];
+	int offset = CONFIG_RW_STORAGE_OFF;
+	uint64_t start;
+	int i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i;
+
+	start = get_wall_time_us();
+	for (i = 0; i < OP_COUNT; i++) {
+		TEST_ASSERT(flash_physical_write(offset, sizeof(buf), buf) ==
+			    EC_SUCCESS);
+		offset += sizeof(buf);
+		if (offset + sizeof(buf) > CONFIG_RW_STORAGE_OFF + CONFIG_RW_SIZE)
+			offset = CONFIG_RW_STORAGE_OFF;
+	}
+	test_print_rate(OP_COUNT, "writes", "writes",
+			get_wall_time_us() - start);
+
+	TEST_ASSERT_ARRAY_EQ((char *)CONFIG_FLASH_BASE + CONFIG_RW_STORAGE_OFF,
+			     buf, sizeof(buf));
+
+	return EC_SUCCESS;
+}
+
+static int test_erase_rate(void)
+{
+	int offset = CONFIG_RW_STORAGE_OFF;
+	uint64_t start;
+	int i;
+
+	start = get_wall_time_us();
+	for (i = 0; i < OP_COUNT; i++) {
+		TEST_ASSERT(flash_physical_erase(offset,
+				CONFIG_FLASH_ERASE_SIZE) == EC_SUCCESS);
+		offset += CONFIG_FLASH_ERASE_SIZE;
+		if (offset >= CONFIG_RW_STORAGE_OFF + CONFIG_RW_SIZE)
+			offset = CONFIG_RW_STORAGE_OFF;
+	}
+	test_print_rate(OP_COUNT, "erases", "erases",
+			get_wall_time_us() - start);
+
+	TEST_ASSERT(flash_is_erased(CONFIG_RW_STORAGE_OFF,
+				    CONFIG_FLASH_ERASE_SIZE));
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	RUN_TEST(test_write_rate);
+	RUN_TEST(test_erase_rate);
+
+	test_print_result();
+}
@@ -12,7 +12,6 @@
 #include "timer.h"
 #include "util.h"
 
-static int init_hook_count;
 static int tick_hook_count;
 static int tick2_hook_count;
 static int tick_count_seen_by_tick2;
@@ -21,12 +20,27 @@ static int second_hook_count;
 static timestamp_t second_time[2];
 static int deferred_call_count;
 
+static int init_hook_count;
+static char init_hook_order[4];
+
+static void init_hook_last(void)
+{
+	init_hook_order[init_hook_count++] = 'L';
+}
+DECLARE_HOOK(HOOK_INIT, init_hook_last, HOOK_PRIO_LAST);
+
 static void init_hook(void)
 {
-	init_hook_count++;
+	init_hook_order[init_hook_count++] = 'D';
 }
 DECLARE_HOOK(HOOK_INIT, init_hook, HOOK_PRIO_DEFAULT);
 
+static void init_hook_first(void)
+{
+	init_hook_order[init_hook_count++] = 'F';
+}
+DECLARE_HOOK(HOOK_INIT, init_hook_first, HOOK_PRIO_FIRST);
+
 static void tick_hook(void)
 {
 	tick_hook_count++;
@@ -62,9 +76,70 @@ static void non_deferred_func(void)
 	deferred_call_count++;
 }
 
+/*
+ * Many deferred routines, to check that arming and dispatch still work (and
+ * stay fast) with far more routines than a board usually has.
+ */
+#define MANY_DEFERRED_COUNT 64
+
+static int many_call_count;
+static uint8_t many_call_order[MANY_DEFERRED_COUNT];
+static timestamp_t many_call_time[MANY_DEFERRED_COUNT];
+
+static void many_deferred_called(int n)
+{
+	many_call_time[n] = get_time();
+	if (many_call_count < MANY_DEFERRED_COUNT)
+		many_call_order[many_call_count] = n;
+	many_call_count++;
+}
+
+#define DECLARE_MANY_DEFERRED(n, d)					\
+	static void many_deferred_##n##d(void)				\
+	{								\
+		many_deferred_called(n * 8 + d);			\
+	}								\
+	DECLARE_DEFERRED(many_deferred_##n##d)
+
+#define DECLARE_MANY_DEFERRED_8(n)					\
+	DECLARE_MANY_DEFERRED(n, 0); DECLARE_MANY_DEFERRED(n, 1);	\
+	DECLARE_MANY_DEFERRED(n, 2); DECLARE_MANY_DEFERRED(n, 3);	\
+	DECLARE_MANY_DEFERRED(n, 4); DECLARE_MANY_DEFERRED(n, 5);	\
+	DECLARE_MANY_DEFERRED(n, 6); DECLARE_MANY_DEFERRED(n, 7)
+
+#define MANY_DEFERRED_DATA_8(n)						\
+	&many_deferred_##n##0_data, &many_deferred_##n##1_data,		\
+	&many_deferred_##n##2_data, &many_deferred_##n##3_data,		\
+	&many_deferred_##n##4_data, &many_deferred_##n##5_data,		\
+	&many_deferred_##n##6_data, &many_deferred_##n##7_data
+
+DECLARE_MANY_DEFERRED_8(0);
+DECLARE_MANY_DEFERRED_8(1);
+DECLARE_MANY_DEFERRED_8(2);
+DECLARE_MANY_DEFERRED_8(3);
+DECLARE_MANY_DEFERRED_8(4);
+DECLARE_MANY_DEFERRED_8(5);
+DECLARE_MANY_DEFERRED_8(6);
+DECLARE_MANY_DEFERRED_8(7);
+
+static const struct deferred_data *many_deferred[MANY_DEFERRED_COUNT] = {
+	MANY_DEFERRED_DATA_8(0), MANY_DEFERRED_DATA_8(1),
+	MANY_DEFERRED_DATA_8(2), MANY_DEFERRED_DATA_8(3),
+	MANY_DEFERRED_DATA_8(4), MANY_DEFERRED_DATA_8(5),
+	MANY_DEFERRED_DATA_8(6), MANY_DEFERRED_DATA_8(7),
+};
+
+/* Distinct delays, 1ms apart, in a scrambled order */
+static int many_deferred_delay(int n)
+{
+	return 10 * MSEC + ((n * 37) % MANY_DEFERRED_COUNT) * MSEC;
+}
+
 static int test_init_hook(void)
 {
-	TEST_ASSERT(init_hook_count == 1);
+	/* Declared out of order, called in priority order */
+	TEST_ASSERT(init_hook_count == 3);
+	TEST_ASSERT_ARRAY_EQ(init_hook_order, "FDL", 3);
 	return EC_SUCCESS;
 }
 
@@ -101,6 +176,19 @@ static int test_priority(void)
 	return EC_SUCCESS;
 }
 
+static int test_routine_stats(void)
+{
+	const struct hook_stats *stats = __hook_HOOK_TICK_tick_hook.stats;
+
+	/* The hook task may be between the call and updating the stats */
+	TEST_ASSERT(stats->calls <= tick_hook_count);
+	TEST_ASSERT(stats->calls + 1 >= tick_hook_count);
+	TEST_ASSERT(stats->max_run_time >= stats->last_run_time);
+	TEST_ASSERT(__hook_HOOK_INIT_init_hook.stats->calls == 1);
+
+	return EC_SUCCESS;
+}
+
 static int test_deferred(void)
 {
 	deferred_call_count = 0;
@@ -130,6 +218,61 @@ static int test_deferred(void)
 	return EC_SUCCESS;
 }
 
+static int test_deferred_many(void)
+{
+	timestamp_t start;
+	uint64_t arm_time;
+	int i;
+
+	many_call_count = 0;
+	start = get_time();
+	for (i = 0; i < MANY_DEFERRED_COUNT; i++)
+		TEST_ASSERT(hook_call_deferred_data(many_deferred[i],
+					many_deferred_delay(i)) == EC_SUCCESS);
+	arm_time = get_time().val - start.val;
+	ccprintf("Armed %d deferred calls in %d us\n", MANY_DEFERRED_COUNT,
+		 (int)arm_time);
+
+	usleep(100 * MSEC);
+	TEST_ASSERT(many_call_count == MANY_DEFERRED_COUNT);
+
+	/* Each routine ran on time, and in order of deadline */
+	for (i = 0; i < MANY_DEFERRED_COUNT; i++) {
+		int64_t late = many_call_time[i].val - start.val -
+			       many_deferred_delay(i);
+
+		TEST_ASSERT(late >= 0);
+		TEST_ASSERT(late < 20 * MSEC);
+		if (i > 0)
+			TEST_ASSERT(many_deferred_delay(many_call_order[i]) >
+				    many_deferred_delay(many_call_order[i - 1]));
+	}
+
+	/* Cancel every other routine after arming all of them */
+	many_call_count = 0;
+	for (i = 0; i < MANY_DEFERRED_COUNT; i++)
+		hook_call_deferred_data(many_deferred[i],
+					many_deferred_delay(i));
+	for (i = 1; i < MANY_DEFERRED_COUNT; i += 2)
+		hook_call_deferred_data(many_deferred[i], -1);
+	usleep(100 * MSEC);
+	TEST_ASSERT(many_call_count == MANY_DEFERRED_COUNT / 2);
+	for (i = 0; i < many_call_count; i++)
+		TEST_ASSERT(!(many_call_order[i] & 1));
+
+	/* Re-arming a pending routine moves it rather than queueing twice */
+	many_call_count = 0;
+	hook_call_deferred_data(many_deferred[0], 50 * MSEC);
+	hook_call_deferred_data(many_deferred[1], 20 * MSEC);
+	hook_call_deferred_data(many_deferred[0], 10 * MSEC);
+	usleep(100 * MSEC);
+	TEST_ASSERT(many_call_count == 2);
+	TEST_ASSERT(many_call_order[0] == 0);
+	TEST_ASSERT(many_call_order[1] == 1);
+
+	return EC_SUCCESS;
+}
+
 void run_test(void)
 {
 	test_reset();
@@ -137,7 +280,9 @@ void run_test(void)
 	RUN_TEST(test_init_hook);
 	RUN_TEST(test_ticks);
 	RUN_TEST(test_priority);
+	RUN_TEST(test_routine_stats);
 	RUN_TEST(test_deferred);
+	RUN_TEST(test_deferred_many);
 
 	test_print_result();
 }
@@ -7,7 +7,9 @@
 
 #include "common.h"
 #include "console.h"
+#include "hooks.h"
 #include "host_command.h"
+#include "link_defs.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -167,6 +169,476 @@ static int test_hostcmd_invalid_checksum(void)
 	return EC_SUCCESS;
 }
 
+static int test_hostcmd_all_found(void)
+{
+	const struct host_command *cmd, *first;
+	struct ec_params_get_cmd_versions_v1 p;
+	struct ec_response_get_cmd_versions r;
+
+	/* Every declared command can be looked up */
+	for (cmd = __hcmds; cmd < __hcmds_end; cmd++) {
+		/* The first declaration wins */
+		for (first = __hcmds; first->command != cmd->command; first++)
+			;
+
+		p.cmd = cmd->command;
+		TEST_ASSERT(test_send_host_command(EC_CMD_GET_CMD_VERSIONS, 1,
+						   &p, sizeof(p),
+						   &r, sizeof(r)) ==
+			    EC_RES_SUCCESS);
+		TEST_ASSERT(r.version_mask == first->version_mask);
+	}
+
+	return EC_SUCCESS;
+}
+
+/* Add a sub-command to a batch request; returns the new request size */
+static int batch_add(uint8_t *buf, int size, int command, int version,
+		     const void *params, int params_size, int response_max)
+{
+	struct ec_params_batch *p = (struct ec_params_batch *)buf;
+	struct ec_batch_request *req = (struct ec_batch_request *)(buf + size);
+
+	p->count++;
+	req->command = command;
+	req->version = version;
+	req->reserved = 0;
+	req->size = params_size;
+	req->response_max = response_max;
+	memcpy(req + 1, params, params_size);
+
+	return size + sizeof(*req) + EC_BATCH_ALIGN(params_size);
+}
+
+static int test_hostcmd_batch(void)
+{
+	/* The response overwrites the request, as it does over LPC */
+	static uint32_t buf[32];
+	uint8_t *b = (uint8_t *)buf;
+	struct ec_params_hello hello = { .in_data = 0x11223344 };
+	struct ec_params_get_cmd_versions_v1 versions = {
+		.cmd = EC_CMD_BATCH };
+	struct ec_params_host_command_stats stats = { .index = 0 };
+	struct ec_response_batch *r = (struct ec_response_batch *)buf;
+	struct ec_batch_response *resp;
+	struct host_cmd_handler_args args;
+	int size = sizeof(struct ec_params_batch);
+	int i;
+
+	memset(buf, 0, sizeof(buf));
+	size = batch_add(b, size, EC_CMD_HELLO, 0, &hello, sizeof(hello),
+			 sizeof(struct ec_response_hello));
+	size = batch_add(b, size, 0xff, 0, NULL, 0, 0);
+	size = batch_add(b, size, EC_CMD_GET_CMD_VERSIONS, 1, &versions,
+			 sizeof(versions),
+			 sizeof(struct ec_response_get_cmd_versions));
+	size = batch_add(b, size, EC_CMD_BATCH, 0, NULL, 0, 0);
+	/* No room for this response */
+	size = batch_add(b, size, EC_CMD_HELLO, 0, &hello, sizeof(hello),
+			 sizeof(buf));
+
+	args.send_response = NULL;
+	args.command = EC_CMD_BATCH;
+	args.version = 0;
+	args.params = buf;
+	args.params_size = size;
+	args.response = buf;
+	args.response_max = sizeof(buf);
+	args.response_size = 0;
+	TEST_ASSERT(host_command_process(&args) == EC_RES_SUCCESS);
+
+	TEST_ASSERT(r->count == 4);
+
+	/* Each sub-command has its own result and response */
+	resp = (struct ec_batch_response *)(r + 1);
+	TEST_ASSERT(resp->result == EC_RES_SUCCESS);
+	TEST_ASSERT(resp->size == sizeof(struct ec_response_hello));
+	TEST_ASSERT(((struct ec_response_hello *)(resp + 1))->out_data ==
+		    0x12243648);
+
+	resp = (void *)((uint8_t *)(resp + 1) + EC_BATCH_ALIGN(resp->size));
+	TEST_ASSERT(resp->result == EC_RES_INVALID_COMMAND);
+	TEST_ASSERT(resp->size == 0);
+
+	resp = (void *)((uint8_t *)(resp + 1) + EC_BATCH_ALIGN(resp->size));
+	TEST_ASSERT(resp->result == EC_RES_SUCCESS);
+	TEST_ASSERT(((struct ec_response_get_cmd_versions *)(resp + 1))
+		    ->version_mask == EC_VER_MASK(0));
+
+	/* Batches don't nest */
+	resp = (void *)((uint8_t *)(resp + 1) + EC_BATCH_ALIGN(resp->size));
+	TEST_ASSERT(resp->result == EC_RES_INVALID_COMMAND);
+
+	resp = (void *)((uint8_t *)(resp + 1) + EC_BATCH_ALIGN(resp->size));
+	TEST_ASSERT((uint8_t *)resp - b == args.response_size);
+
+	/* A sub-command running past the end of the request runs nothing */
+	memset(buf, 0, sizeof(buf));
+	size = batch_add(b, sizeof(struct ec_params_batch), EC_CMD_HELLO, 0,
+			 &hello, sizeof(hello),
+			 sizeof(struct ec_response_hello));
+	args.params_size = size - 1;
+	TEST_ASSERT(host_command_process(&args) == EC_RES_REQUEST_TRUNCATED);
+
+	/*
+	 * A response bigger than the space asked for isn't passed back, even
+	 * when the handler's whole response wouldn't fit in what's left.
+	 */
+	memset(buf, 0, sizeof(buf));
+	size = sizeof(struct ec_params_batch);
+	for (i = 0; i < 2; i++)
+		size = batch_add(b, size, EC_CMD_HELLO, 0, &hello,
+				 sizeof(hello),
+				 sizeof(struct ec_response_hello));
+	size = batch_add(b, size, EC_CMD_HOST_COMMAND_STATS, 0, &stats,
+			 sizeof(stats), 0);
+	args.params_size = size;
+	/* Leaves 16 bytes for the stats, which are bigger than that */
+	args.response_max = size;
+	memset(b + args.response_max, 0xa5, sizeof(buf) - args.response_max);
+	TEST_ASSERT(host_command_process(&args) == EC_RES_SUCCESS);
+	TEST_ASSERT(r->count == 3);
+
+	resp = (struct ec_batch_response *)(r + 1);
+	for (i = 0; i < 2; i++) {
+		TEST_ASSERT(resp->result == EC_RES_SUCCESS);
+		resp = (void *)((uint8_t *)(resp + 1) +
+				EC_BATCH_ALIGN(resp->size));
+	}
+	TEST_ASSERT(resp->result == EC_RES_INVALID_RESPONSE);
+	TEST_ASSERT(resp->size == 0);
+	for (i = args.response_max; i < sizeof(buf); i++)
+		TEST_ASSERT(b[i] == 0xa5);
+
+	return EC_SUCCESS;
+}
+
+/* Read the statistics of a command; returns its index, or -1 */
+static int read_stats(int command, struct ec_response_host_command_stats *r,
+		      int flags)
+{
+	struct ec_params_host_command_stats p;
+	int i;
+
+	for (i = 0; i < __hcmds_end - __hcmds; i++) {
+		if (__hcmds[i].command != command)
+			continue;
+		p.index = i;
+		p.flags = flags;
+		if (test_send_host_command(EC_CMD_HOST_COMMAND_STATS, 0,
+					   &p, sizeof(p), r, sizeof(*r)))
+			return -1;
+		return i;
+	}
+
+	return -1;
+}
+
+static int test_hostcmd_stats(void)
+{
+	struct ec_response_host_command_stats r;
+	struct ec_params_host_command_stats p;
+	int i;
+
+	/* Start from zero */
+	TEST_ASSERT(read_stats(EC_CMD_HELLO, &r,
+			       EC_HOST_COMMAND_STATS_FLAG_RESET) >= 0);
+	TEST_ASSERT(r.count == __hcmds_end - __hcmds);
+	TEST_ASSERT(r.command == EC_CMD_HELLO);
+
+	hostcmd_fill_in_default();
+	for (i = 0; i < 3; i++) {
+		req->checksum = 0;
+		hostcmd_send();
+	}
+	req->command_version = 1;
+	req->checksum = 0;
+	hostcmd_send();
+	TEST_ASSERT(resp->result == EC_RES_INVALID_VERSION);
+
+	TEST_ASSERT(read_stats(EC_CMD_HELLO, &r, 0) >= 0);
+	TEST_ASSERT(r.calls == 4);
+	TEST_ASSERT(r.errors == 1);
+	TEST_ASSERT(r.max_time <= r.total_time);
+
+	/* Past the end of the table */
+	p.index = r.count;
+	p.flags = 0;
+	TEST_ASSERT(test_send_host_command(EC_CMD_HOST_COMMAND_STATS, 0,
+					   &p, sizeof(p), &r, sizeof(r)) ==
+		    EC_RES_INVALID_PARAM);
+
+	return EC_SUCCESS;
+}
+
+/* Test-only command which finishes in the background */
+#define TEST_CMD_ASYNC 0x7e
+
+static volatile int async_release;
+static volatile int tick_count;
+
+static void count_tick(void)
+{
+	tick_count++;
+}
+DECLARE_HOOK(HOOK_TICK, count_tick, HOOK_PRIO_DEFAULT);
+
+static int async_routine(struct host_cmd_handler_args *args)
+{
+	const uint32_t *in = args->params;
+	uint32_t *out = args->response;
+
+	if (!async_release)
+		return EC_RES_IN_PROGRESS;
+
+	*out = *in + 1;
+	args->response_size = sizeof(*out);
+	return EC_RES_SUCCESS;
+}
+
+static int async_command(struct host_cmd_handler_args *args)
+{
+	return host_command_async(args, async_routine);
+}
+DECLARE_HOST_COMMAND(TEST_CMD_ASYNC, async_command, EC_VER_MASK(0));
+
+static int comms_status(void)
+{
+	struct ec_response_get_comms_status s;
+
+	if (test_send_host_command(EC_CMD_GET_COMMS_STATUS, 0, NULL, 0,
+				   &s, sizeof(s)) != EC_RES_SUCCESS)
+		return -1;
+	return s.flags;
+}
+
+static int test_hostcmd_async(void)
+{
+	struct host_cmd_handler_args args;
+	uint32_t data;
+	int ticks;
+	int i;
+
+	async_release = 0;
+	hostcmd_fill_in_default();
+	req->command = TEST_CMD_ASYNC;
+	hostcmd_send();
+	TEST_ASSERT(resp->result == EC_RES_IN_PROGRESS);
+	TEST_ASSERT(resp->data_len == 0);
+
+	/* Hooks keep running between its steps */
+	ticks = tick_count;
+	msleep(3 * HOOK_TICK_INTERVAL_MS);
+	TEST_ASSERT(tick_count > ticks);
+
+	/* Other commands still work while it runs, but not another one */
+	TEST_ASSERT(comms_status() == EC_COMMS_STATUS_PROCESSING);
+	hostcmd_fill_in_default();
+	hostcmd_send();
+	TEST_ASSERT(resp->result == EC_RES_SUCCESS);
+	TEST_ASSERT(r->out_data == 0x12243648);
+	req->command = TEST_CMD_ASYNC;
+	req->checksum = 0;
+	hostcmd_send();
+	TEST_ASSERT(resp->result == EC_RES_BUSY);
+	TEST_ASSERT(test_send_host_command(EC_CMD_RESEND_RESPONSE, 0, NULL, 0,
+					   &data, sizeof(data)) ==
+		    EC_RES_BUSY);
+
+	async_release = 1;
+	for (i = 0; i < 10 && comms_status(); i++)
+		msleep(10);
+	TEST_ASSERT(comms_status() == 0);
+
+	/* The result can be collected once */
+	args.send_response = NULL;
+	args.command = EC_CMD_RESEND_RESPONSE;
+	args.version = 0;
+	args.params = NULL;
+	args.params_size = 0;
+	args.response = &data;
+	args.response_max = sizeof(data);
+	args.response_size = 0;
+	TEST_ASSERT(host_command_process(&args) == EC_RES_SUCCESS);
+	TEST_ASSERT(args.response_size == sizeof(data));
+	TEST_ASSERT(data == 0x11223345);
+	TEST_ASSERT(test_send_host_command(EC_CMD_RESEND_RESPONSE, 0, NULL, 0,
+					   &data, sizeof(data)) ==
+		    EC_RES_UNAVAILABLE);
+
+	/* Commands which don't come from the host finish right away */
+	data = 41;
+	TEST_ASSERT(test_send_host_command(TEST_CMD_ASYNC, 0, &data,
+					   sizeof(data), &data,
+					   sizeof(data)) == EC_RES_SUCCESS);
+	TEST_ASSERT(data == 42);
+
+	return EC_SUCCESS;
+}
+
+/* Write a few bytes at the start of RW */
+static void send_flash_write(void)
+{
+	struct ec_params_flash_write *write = (void *)(req + 1);
+
+	hostcmd_fill_in_default();
+	req->command = EC_CMD_FLASH_WRITE;
+	req->command_version = EC_VER_FLASH_WRITE;
+	req->data_len = sizeof(*write) + 4;
+	write->offset = CONFIG_RW_STORAGE_OFF;
+	write->size = 4;
+	memset(write + 1, 0x5a, 4);
+	pkt.request_size = sizeof(*req) + req->data_len;
+	hostcmd_send();
+}
+
+static int test_hostcmd_flash_busy(void)
+{
+	struct ec_params_flash_erase *erase = (void *)(req + 1);
+	struct ec_params_flash_protect *protect = (void *)(req + 1);
+	int i;
+
+	/* Start erasing a bank in the background */
+	hostcmd_fill_in_default();
+	req->command = EC_CMD_FLASH_ERASE;
+	req->data_len = sizeof(*erase);
+	erase->offset = CONFIG_RW_STORAGE_OFF;
+	erase->size = CONFIG_FLASH_BANK_SIZE;
+	pkt.request_size = sizeof(*req) + sizeof(*erase);
+	hostcmd_send();
+	TEST_ASSERT(resp->result == EC_RES_IN_PROGRESS);
+
+	/* Flash can't be written or protected until it's done */
+	send_flash_write();
+	TEST_ASSERT(resp->result == EC_RES_BUSY);
+	TEST_ASSERT(comms_status() == EC_COMMS_STATUS_PROCESSING);
+
+	hostcmd_fill_in_default();
+	req->command = EC_CMD_FLASH_PROTECT;
+	req->command_version = EC_VER_FLASH_PROTECT;
+	req->data_len = sizeof(*protect);
+	protect->mask = 0;
+	protect->flags = 0;
+	pkt.request_size = sizeof(*req) + sizeof(*protect);
+	hostcmd_send();
+	TEST_ASSERT(resp->result == EC_RES_BUSY);
+
+	for (i = 0; i < 100 && comms_status(); i++)
+		msleep(10);
+	TEST_ASSERT(comms_status() == 0);
+	TEST_ASSERT(test_send_host_command(EC_CMD_RESEND_RESPONSE, 0, NULL, 0,
+					   NULL, 0) == EC_RES_SUCCESS);
+
+	/* Then the write goes ahead */
+	send_flash_write();
+	TEST_ASSERT(resp->result == EC_RES_SUCCESS);
+
+	return EC_SUCCESS;
+}
+
+static int memmap_snapshot(int offset, int size, int flags, int seq,
+			   struct ec_response_memmap_snapshot *r, int *r_size)
+{
+	struct ec_params_memmap_snapshot p;
+	struct host_cmd_handler_args args;
+	int rv;
+
+	p.offset = offset;
+	p.size = size;
+	p.flags = flags;
+	p.seq = seq;
+
+	args.send_response = NULL;
+	args.command = EC_CMD_MEMMAP_SNAPSHOT;
+	args.version = 0;
+	args.params = &p;
+	args.params_size = sizeof(p);
+	args.response = r;
+	args.response_max = sizeof(*r) + 8;
+	args.response_size = 0;
+
+	rv = host_command_process(&args);
+	*r_size = args.response_size;
+	return rv;
+}
+
+static int test_hostcmd_memmap_snapshot(void)
+{
+	struct {
+		struct ec_response_memmap_snapshot r;
+		uint8_t data[8];
+	} resp;
+	int size, seq;
+
+	/* The ID area says the sequence number is there */
+	TEST_ASSERT(memmap_snapshot(EC_MEMMAP_ID, 3, 0, 0, &resp.r, &size) ==
+		    EC_RES_SUCCESS);
+	TEST_ASSERT(size == sizeof(resp.r) + 3);
+	TEST_ASSERT(resp.r.flags == 0);
+	TEST_ASSERT_ARRAY_EQ(resp.r.data, "EC\x02", 3);
+	seq = resp.r.seq;
+
+	/* No data if nothing changed */
+	TEST_ASSERT(memmap_snapshot(EC_MEMMAP_ID, 3,
+				    EC_MEMMAP_SNAPSHOT_IF_CHANGED, seq,
+				    &resp.r, &size) == EC_RES_SUCCESS);
+	TEST_ASSERT(size == sizeof(resp.r));
+	TEST_ASSERT(resp.r.flags == EC_MEMMAP_SNAPSHOT_UNCHANGED);
+	TEST_ASSERT(resp.r.seq == seq);
+
+	/* Not while an update is in progress */
+	host_memmap_update_begin();
+	TEST_ASSERT(*host_get_memmap(EC_MEMMAP_UPDATE_BUSY) == 1);
+	TEST_ASSERT(memmap_snapshot(EC_MEMMAP_ID, 3, 0, 0, &resp.r, &size) ==
+		    EC_RES_BUSY);
+	host_memmap_update_end();
+	TEST_ASSERT(*host_get_memmap(EC_MEMMAP_UPDATE_BUSY) == 0);
+
+	/* But afterwards, and the update is noticed */
+	TEST_ASSERT(memmap_snapshot(EC_MEMMAP_ID, 3,
+				    EC_MEMMAP_SNAPSHOT_IF_CHANGED, seq,
+				    &resp.r, &size) == EC_RES_SUCCESS);
+	TEST_ASSERT(size == sizeof(resp.r) + 3);
+	TEST_ASSERT(resp.r.flags == 0);
+	TEST_ASSERT(resp.r.seq != seq);
+
+	/* Past the end of the memory map, or the response */
+	TEST_ASSERT(memmap_snapshot(EC_MEMMAP_SIZE - 2, 3, 0, 0,
+				    &resp.r, &size) == EC_RES_INVALID_PARAM);
+	TEST_ASSERT(memmap_snapshot(EC_MEMMAP_ID, 9, 0, 0,
+				    &resp.r, &size) == EC_RES_INVALID_PARAM);
+
+	return EC_SUCCESS;
+}
+
+#define ROUND_TRIPS 10000
+
+static int test_hostcmd_rate(void)
+{
+	uint64_t start, elapsed;
+	int i;
+
+	/* Don't count printing each command */
+	UART_INJECT("hcdebug off\n");
+	msleep(30);
+
+	hostcmd_fill_in_default();
+	start = get_wall_time_us();
+	for (i = 0; i < ROUND_TRIPS; i++) {
+		req->checksum = 0;
+		hostcmd_send();
+		TEST_ASSERT(resp->result == EC_RES_SUCCESS);
+	}
+	elapsed = get_wall_time_us() - start;
+
+	test_print_rate(ROUND_TRIPS, "round trips", "round trips", elapsed);
+
+	UART_INJECT("hcdebug normal\n");
+	msleep(30);
+
+	return EC_SUCCESS;
+}
+
 void run_test(void)
 {
 	wait_for_task_started();
@@ -180,6 +652,13 @@ void run_test(void)
 	RUN_TEST(test_hostcmd_wrong_command_version);
 	RUN_TEST(test_hostcmd_wrong_struct_version);
 	RUN_TEST(test_hostcmd_invalid_checksum);
+	RUN_TEST(test_hostcmd_all_found);
+	RUN_TEST(test_hostcmd_batch);
+	RUN_TEST(test_hostcmd_stats);
+	RUN_TEST(test_hostcmd_async);
+	RUN_TEST(test_hostcmd_flash_busy);
+	RUN_TEST(test_hostcmd_memmap_snapshot);
+	RUN_TEST(test_hostcmd_rate);
 
 	test_print_result();
 }
@@ -7,6 +7,7 @@
 
 #include "common.h"
 #include "console.h"
+#include "host_command.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -16,6 +17,34 @@
 
 static int wake_count[3];
 
+#if defined(CONFIG_TASK_STATS) && defined(HAS_TASK_HOSTCMD)
+/* Every wake-up of a ping-pong task must show up in its histograms */
+static int check_task_stats(void)
+{
+	struct ec_params_task_stats p;
+	struct ec_response_task_stats r;
+	int total = 0;
+	int i;
+
+	p.task_id = TASK_ID_TESTB;
+	p.flags = EC_TASK_STATS_FLAG_RESET;
+	if (test_send_host_command(EC_CMD_TASK_STATS, 0, &p, sizeof(p),
+				   &r, sizeof(r)) != EC_RES_SUCCESS)
+		return 0;
+
+	for (i = 0; i < EC_TASK_STATS_BUCKETS; i++)
+		total += r.wake_latency[i];
+
+	return r.task_count == TASK_ID_COUNT && !strcasecmp(r.name, "TESTB") &&
+	       total >= TEST_COUNT;
+}
+#else
+static int check_task_stats(void)
+{
+	return 1;
+}
+#endif
+
 int task_abc(void *data)
 {
 	int myid = task_get_current() - TASK_ID_TESTA;
@@ -31,7 +60,7 @@ int task_abc(void *data)
 		wake_count[myid]++;
 		if (myid == 2 && wake_count[myid] == TEST_COUNT) {
 			if (wake_count[0] == TEST_COUNT &&
-			    wake_count[1] == TEST_COUNT)
+			    wake_count[1] == TEST_COUNT && check_task_stats())
 				test_pass();
 			else
 				test_fail();
@@ -0,0 +1,143 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Formatted output test, reporting formatted lines per second.
+ */
+#include <stdarg.h>
+#include "common.h"
+#include "console.h"
+#include "printf.h"
+#include "test_util.h"
+#include "util.h"
+
+#define LINE_COUNT 200000
+
+/* A typical PD negotiation log line */
+#define BENCH_FORMAT "[%.6ld C%d RECV %04x/%d 0x%08x %d mV %d mA]\n"
+#define BENCH_ARGS(i) (1234567890123ll + (i)), (i) & 1, 0x1161, (i) & 7, \
+		(0x2191912c + (i)), 20000 - (i), -(3000 + (i))
+#define BENCH_LINE_5 \
+	"[1234567.890128 C1 RECV 1161/5 0x21919131 19995 mV -3005 mA]\n"
+
+static char line[128];
+static int line_len;
+
+static int line_addchar(void *context, int c)
+{
+	if (line_len >= sizeof(line))
+		return 1;
+	line[line_len++] = c;
+	return 0;
+}
+
+static int line_addstr(void *context, const char *str, int len)
+{
+	if (line_len + len > sizeof(line))
+		return 1;
+	memcpy(line + line_len, str, len);
+	line_len += len;
+	return 0;
+}
+
+static int format_chars(const char *format, ...)
+{
+	va_list args;
+	int rv;
+
+	line_len = 0;
+	va_start(args, format);
+	rv = vfnprintf(line_addchar, NULL, format, args);
+	va_end(args);
+	return rv;
+}
+
+static int format_runs(const char *format, ...)
+{
+	va_list args;
+	int rv;
+
+	line_len = 0;
+	va_start(args, format);
+	rv = vfnprintf_str(line_addstr, NULL, format, args);
+	va_end(args);
+	return rv;
+}
+
+#define TEST_FORMAT(expected, format, ...)				\
+	do {								\
+		char buf[64];						\
+		TEST_ASSERT(snprintf(buf, sizeof(buf), format,		\
+				     ##__VA_ARGS__) == EC_SUCCESS);	\
+		TEST_ASSERT_ARRAY_EQ(buf, expected, sizeof(expected));	\
+	} while (0)
+
+static int test_formats(void)
+{
+	char buf[8];
+
+	TEST_FORMAT("0", "%d", 0);
+	TEST_FORMAT("-2147483648", "%d", -2147483647 - 1);
+	TEST_FORMAT("4294967295", "%u", 0xffffffff);
+	TEST_FORMAT("18446744073709551615", "%lu", 0xffffffffffffffffull);
+	TEST_FORMAT("-9223372036854775808", "%ld", 1ull << 63);
+	TEST_FORMAT("1000000000000", "%ld", 1000000000000ll);
+	TEST_FORMAT("dead BEEF", "%x %X", 0xdead, 0xbeef);
+	TEST_FORMAT("fedcba9876543210", "%lx", 0xfedcba9876543210ull);
+	TEST_FORMAT("101", "%b", 5);
+	TEST_FORMAT("0.000123", "%.6d", 123);
+	TEST_FORMAT("-1.5", "%.1d", -15);
+	TEST_FORMAT("1234567.890123", "%.6ld", 1234567890123ll);
+	TEST_FORMAT("[  42|42  |0042]", "[%4d|%-4d|%04d]", 42, 42, 42);
+	TEST_FORMAT("[abc|   ab]", "[%.3s|%5s]", "abcdef", "ab");
+	TEST_FORMAT("0123abff", "%.4h", "\x01\x23\xab\xff");
+	TEST_FORMAT("50% c", "50%% %c", 'c');
+	TEST_FORMAT("ERROR", "%y", 1);
+
+	/* Truncation */
+	TEST_ASSERT(snprintf(buf, sizeof(buf), "%d%s", 1234, "5678") ==
+		    EC_ERROR_OVERFLOW);
+	TEST_ASSERT_ARRAY_EQ(buf, "1234567", sizeof(buf));
+
+	/* Both output interfaces produce the same text */
+	TEST_ASSERT(format_chars(BENCH_FORMAT, BENCH_ARGS(5)) == EC_SUCCESS);
+	TEST_ASSERT(line_len == sizeof(BENCH_LINE_5) - 1);
+	TEST_ASSERT_ARRAY_EQ(line, BENCH_LINE_5, line_len);
+	TEST_ASSERT(format_runs(BENCH_FORMAT, BENCH_ARGS(5)) == EC_SUCCESS);
+	TEST_ASSERT(line_len == sizeof(BENCH_LINE_5) - 1);
+	TEST_ASSERT_ARRAY_EQ(line, BENCH_LINE_5, line_len);
+
+	return EC_SUCCESS;
+}
+
+static int test_line_rate(void)
+{
+	uint64_t start;
+	int i;
+
+	start = get_wall_time_us();
+	for (i = 0; i < LINE_COUNT; i++)
+		TEST_ASSERT(format_chars(BENCH_FORMAT, BENCH_ARGS(i)) ==
+			    EC_SUCCESS);
+	test_print_rate(LINE_COUNT, "lines by character", "lines",
+			get_wall_time_us() - start);
+
+	start = get_wall_time_us();
+	for (i = 0; i < LINE_COUNT; i++)
+		TEST_ASSERT(format_runs(BENCH_FORMAT, BENCH_ARGS(i)) ==
+			    EC_SUCCESS);
+	test_print_rate(LINE_COUNT, "lines by run", "lines",
+			get_wall_time_us() - start);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	RUN_TEST(test_formats);
+	RUN_TEST(test_line_rate);
+
+	test_print_result();
+}
@@ -5,6 +5,9 @@
  * Test queue.
  */
 
+#include <pthread.h>
+#include <sched.h>
+
 #include "common.h"
 #include "console.h"
 #include "queue.h"
@@ -14,6 +17,14 @@
 
 static struct queue const test_queue8 = QUEUE_NULL(8, char);
 static struct queue const test_queue2 = QUEUE_NULL(2, int16_t);
+QUEUE_TYPED(test_queue_typed, 4, uint16_t, queue_policy_null);
+QUEUE_TYPED(bench_queue, 256, uint32_t, queue_policy_null);
+
+/* Units passed through bench_queue for each throughput measurement */
+#define BENCH_UNITS (1 << 21)
+
+/* Units added or removed per batch */
+#define BENCH_BATCH 32
 
 static int test_queue8_empty(void)
 {
@@ -300,6 +311,187 @@ static int test_queue8_chunks_advance(void)
 	return EC_SUCCESS;
 }
 
+static int test_queue8_batch(void)
+{
+	static uint8_t const data[5] = {1, 2, 3, 4, 5};
+	struct queue_batch batch;
+	uint8_t out[5];
+	int i;
+
+	queue_init(&test_queue8);
+
+	/* Move near the end of the queue, so the batch wraps */
+	TEST_ASSERT(queue_advance_tail(&test_queue8, 6) == 6);
+	TEST_ASSERT(queue_advance_head(&test_queue8, 6) == 6);
+
+	/* Units aren't visible until the batch is committed */
+	queue_batch_begin_add(&test_queue8, &batch);
+	for (i = 0; i < 5; i++)
+		TEST_ASSERT(queue_batch_add_unit(&test_queue8, &batch,
+						 data + i) == 1);
+	TEST_ASSERT(queue_is_empty(&test_queue8));
+	TEST_ASSERT(queue_batch_commit_add(&test_queue8, &batch) == 5);
+	TEST_ASSERT(queue_count(&test_queue8) == 5);
+
+	/* A batch can't add more than the space there was at the start */
+	queue_batch_begin_add(&test_queue8, &batch);
+	for (i = 0; i < 3; i++)
+		TEST_ASSERT(queue_batch_add_unit(&test_queue8, &batch,
+						 data + i) == 1);
+	TEST_ASSERT(queue_batch_add_unit(&test_queue8, &batch, data) == 0);
+	TEST_ASSERT(queue_batch_commit_add(&test_queue8, &batch) == 3);
+	TEST_ASSERT(queue_is_full(&test_queue8));
+
+	/* Removed units are only freed when the batch is committed */
+	queue_batch_begin_remove(&test_queue8, &batch);
+	for (i = 0; i < 5; i++)
+		TEST_ASSERT(queue_batch_remove_unit(&test_queue8, &batch,
+						    out + i) == 1);
+	TEST_ASSERT_ARRAY_EQ(out, data, 5);
+	TEST_ASSERT(queue_is_full(&test_queue8));
+	TEST_ASSERT(queue_batch_commit_remove(&test_queue8, &batch) == 5);
+	TEST_ASSERT(queue_count(&test_queue8) == 3);
+
+	queue_batch_begin_remove(&test_queue8, &batch);
+	for (i = 0; i < 3; i++)
+		TEST_ASSERT(queue_batch_remove_unit(&test_queue8, &batch,
+						    out + i) == 1);
+	TEST_ASSERT(queue_batch_remove_unit(&test_queue8, &batch, out) == 0);
+	TEST_ASSERT(queue_batch_commit_remove(&test_queue8, &batch) == 3);
+	TEST_ASSERT_ARRAY_EQ(out, data, 3);
+	TEST_ASSERT(queue_is_empty(&test_queue8));
+
+	return EC_SUCCESS;
+}
+
+static int test_queue_typed_units(void)
+{
+	uint16_t in[6] = {1, 2, 3, 4, 5, 6};
+	uint16_t out[4];
+	int i;
+
+	queue_init(&test_queue_typed);
+
+	/* The specialized and generic accessors can be mixed */
+	for (i = 0; i < 3; i++)
+		TEST_ASSERT(test_queue_typed_add_unit(in + i) == 1);
+	TEST_ASSERT(queue_remove_unit(&test_queue_typed, out) == 1);
+	TEST_ASSERT(out[0] == 1);
+
+	/* Wrap around, and fill the queue */
+	TEST_ASSERT(test_queue_typed_add_unit(in + 3) == 1);
+	TEST_ASSERT(queue_add_unit(&test_queue_typed, in + 4) == 1);
+	TEST_ASSERT(queue_is_full(&test_queue_typed));
+	TEST_ASSERT(test_queue_typed_add_unit(in + 5) == 0);
+
+	for (i = 0; i < 4; i++)
+		TEST_ASSERT(test_queue_typed_remove_unit(out + i) == 1);
+	TEST_ASSERT_ARRAY_EQ(out, in + 1, 4);
+	TEST_ASSERT(test_queue_typed_remove_unit(out) == 0);
+	TEST_ASSERT(queue_is_empty(&test_queue_typed));
+
+	return EC_SUCCESS;
+}
+
+/*
+ * Throughput benchmark.  A separate host thread produces a sequence of
+ * numbers while the test consumes and checks them, so both ends of the queue
+ * really do run at the same time.
+ */
+static enum {
+	BENCH_MODE_UNITS,
+	BENCH_MODE_TYPED_UNITS,
+	BENCH_MODE_BATCHED,
+} bench_mode;
+
+static void *bench_producer(void *arg)
+{
+	struct queue_batch batch;
+	uint32_t next = 0;
+
+	while (next < BENCH_UNITS) {
+		if (bench_mode != BENCH_MODE_BATCHED) {
+			if (bench_mode == BENCH_MODE_TYPED_UNITS ?
+			    bench_queue_add_unit(&next) :
+			    queue_add_unit(&bench_queue, &next))
+				next++;
+			else
+				sched_yield();
+			continue;
+		}
+
+		queue_batch_begin_add(&bench_queue, &batch);
+		while (next < BENCH_UNITS && batch.count < BENCH_BATCH &&
+		       queue_batch_add_unit(&bench_queue, &batch, &next))
+			next++;
+		if (!queue_batch_commit_add(&bench_queue, &batch))
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static int bench_consume(const char *name)
+{
+	struct queue_batch batch;
+	pthread_t producer;
+	uint32_t next = 0;
+	uint32_t unit;
+	uint64_t start, elapsed;
+	int errors = 0;
+
+	queue_init(&bench_queue);
+	start = get_wall_time_us();
+	TEST_ASSERT(pthread_create(&producer, NULL, bench_producer, NULL) == 0);
+
+	while (next < BENCH_UNITS) {
+		if (bench_mode != BENCH_MODE_BATCHED) {
+			if (bench_mode == BENCH_MODE_TYPED_UNITS ?
+			    bench_queue_remove_unit(&unit) :
+			    queue_remove_unit(&bench_queue, &unit))
+				errors += (unit != next++);
+			else
+				sched_yield();
+			continue;
+		}
+
+		queue_batch_begin_remove(&bench_queue, &batch);
+		while (batch.count < BENCH_BATCH &&
+		       queue_batch_remove_unit(&bench_queue, &batch, &unit))
+			errors += (unit != next++);
+		if (!queue_batch_commit_remove(&bench_queue, &batch))
+			sched_yield();
+	}
+
+	pthread_join(producer, NULL);
+	elapsed = get_wall_time_us() - start;
+
+	test_print_rate(BENCH_UNITS, name, "units", elapsed);
+
+	TEST_ASSERT(errors == 0);
+	TEST_ASSERT(queue_is_empty(&bench_queue));
+
+	return EC_SUCCESS;
+}
+
+static int test_queue_bench_units(void)
+{
+	bench_mode = BENCH_MODE_UNITS;
+	return bench_consume("single units");
+}
+
+static int test_queue_bench_typed_units(void)
+{
+	bench_mode = BENCH_MODE_TYPED_UNITS;
+	return bench_consume("specialized single units");
+}
+
+static int test_queue_bench_batched(void)
+{
+	bench_mode = BENCH_MODE_BATCHED;
+	return bench_consume("units in batches of " STRINGIFY(BENCH_BATCH));
+}
+
 void run_test(void)
 {
 	test_reset();
@@ -316,6 +508,11 @@ void run_test(void)
 	RUN_TEST(test_queue8_chunks_full);
 	RUN_TEST(test_queue8_chunks_empty);
 	RUN_TEST(test_queue8_chunks_advance);
+	RUN_TEST(test_queue8_batch);
+	RUN_TEST(test_queue_typed_units);
+	RUN_TEST(test_queue_bench_units);
+	RUN_TEST(test_queue_bench_typed_units);
+	RUN_TEST(test_queue_bench_batched);
 
 	test_print_result();
 }
@@ -0,0 +1,72 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * RSA signature verification test, reporting verify time.  Built once for
+ * each supported key size, to compare them.
+ */
+#include "common.h"
+#include "console.h"
+#include "rsa.h"
+#include "rsa_bench_keys.h"
+#include "sha256.h"
+#include "test_util.h"
+#include "util.h"
+
+#define VERIFY_COUNT 200
+
+/* SHA-256 of the signed message */
+static const uint8_t digest[SHA256_DIGEST_SIZE] = {
+	0xd7, 0xa8, 0xfb, 0xb3, 0x07, 0xd7, 0x80, 0x94,
+	0x69, 0xca, 0x9a, 0xbc, 0xb0, 0x08, 0x2e, 0x4f,
+	0x8d, 0x56, 0x51, 0xe4, 0x6d, 0x3c, 0xdb, 0x76,
+	0x2d, 0x02, 0xd0, 0xbf, 0x37, 0xc9, 0xe5, 0x92};
+
+static uint32_t workbuf[3 * RSANUMWORDS];
+
+static int test_verify(void)
+{
+	uint8_t sig[RSANUMBYTES];
+	uint8_t sha[SHA256_DIGEST_SIZE];
+
+	TEST_ASSERT(rsa_verify(&key, signature, digest, workbuf) == 1);
+
+	/* Wrong signature */
+	memcpy(sig, signature, sizeof(sig));
+	sig[RSANUMBYTES / 2] ^= 0x01;
+	TEST_ASSERT(rsa_verify(&key, sig, digest, workbuf) == 0);
+
+	/* Wrong digest */
+	memcpy(sha, digest, sizeof(sha));
+	sha[SHA256_DIGEST_SIZE - 1] ^= 0x80;
+	TEST_ASSERT(rsa_verify(&key, signature, sha, workbuf) == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_verify_time(void)
+{
+	uint64_t start, elapsed;
+	int i;
+
+	start = get_wall_time_us();
+	for (i = 0; i < VERIFY_COUNT; i++)
+		TEST_ASSERT(rsa_verify(&key, signature, digest, workbuf) == 1);
+	elapsed = get_wall_time_us() - start;
+
+	test_print_rate(VERIFY_COUNT,
+			STRINGIFY(CONFIG_RSA_KEY_SIZE) "-bit verifies",
+			"verifies", elapsed);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	RUN_TEST(test_verify);
+	RUN_TEST(test_verify_time);
+
+	test_print_result();
+}
@@ -0,0 +1,338 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test keys for the RSA test, one for each key size.  Each signature is a
+ * SHA256WithRSA PKCS#1 v1.5 signature of "The quick brown fox jumps over
+ * the lazy dog", made with openssl dgst -sha256 -sign.
+ */
+
+#ifndef __TEST_RSA_BENCH_KEYS_H
+#define __TEST_RSA_BENCH_KEYS_H
+
+#include "rsa.h"
+
+#if CONFIG_RSA_KEY_SIZE == 2048
+static const struct rsa_public_key key = {
+	.n = {
+		0x495471f3, 0xf8cdb66e, 0x7e20c931, 0x97035da6,
+		0x5085e815, 0xcaaaf56f, 0x9ec8799a, 0xadf7b7bd,
+		0x6ccd9b8d, 0xb95bcf42, 0x31692128, 0x56797299,
+		0xb7311275, 0x7ef08fd6, 0x7548b951, 0xfb2cb9a5,
+		0xb396ddbf, 0x93f04112, 0xc077808e, 0xf7859504,
+		0x8abbe738, 0x440c2c7f, 0xcdcddb24, 0x1ee62715,
+		0xe64018ef, 0x46d45e64, 0xa6f01a95, 0x69386d90,
+		0x7fd53af8, 0x5ee0b498, 0x8e7146a1, 0x6df19584,
+		0x35141447, 0x4c165e60, 0xa513971d, 0xf24e0c6d,
+		0x2205980c, 0xd485c359, 0x8012f986, 0x015cff95,
+		0x6e1a09f7, 0x864d5825, 0x87fbbf74, 0x8dbe732d,
+		0x02c57291, 0xfa92f15b, 0x49ca8d29, 0xbb23cebe,
+		0xfab79a9c, 0x888e550d, 0x0a3d67a1, 0x156c989f,
+		0x5c0d4730, 0xdedb94fd, 0x43746da8, 0xe1eb8ab9,
+		0xccd3c56e, 0x3188ee71, 0xbd69e058, 0x5525fdeb,
+		0x0df555f8, 0xe6c33c9f, 0x9a884e4f, 0xb5910f5e,
+	},
+	.rr = {
+		0x6f210390, 0x58d2a337, 0x3e9df0ab, 0x50dc5bd1,
+		0x171253f8, 0xb420005e, 0x690ac5df, 0xd9c859b2,
+		0xaa7aaf37, 0xcc503ad3, 0x13ae12c3, 0x049eb7c4,
+		0x9ba962a6, 0x20ef6b80, 0x9703ef60, 0x05c3394c,
+		0x206cd989, 0x7cebf9b5, 0x1f1df96f, 0x33e037b1,
+		0xf7cfe892, 0xcb3348a8, 0x08dceff0, 0xad065029,
+		0x6ef4d6c8, 0x3acf25bb, 0x5e0b7cf4, 0xa53d2715,
+		0xc6fe9427, 0xaa4f7f9c, 0x158c053b, 0xce7928d9,
+		0x1c201f3f, 0x1efce62e, 0x4f88b94c, 0x3fea28b5,
+		0x127f97a3, 0x5aa82486, 0xf286c907, 0x77a83ea1,
+		0x201b56e3, 0x066c94c5, 0x63bd42af, 0x2fd0868a,
+		0x0932cfa2, 0x41db8ded, 0x1ef62097, 0x3839907d,
+		0x85620e8c, 0xb66fc707, 0x2c9d8181, 0xe3c7d184,
+		0xdb0e23f4, 0x83b737df, 0x4954f634, 0x8c67e11a,
+		0x3301fdcb, 0xe6baa369, 0x7c34de6c, 0x30fcfc53,
+		0x4266ccd7, 0x837d4183, 0x149b3d71, 0x71b29d42,
+	},
+	.n0inv = 0x5fae70c5,
+};
+
+static const uint8_t signature[RSANUMBYTES] = {
+	0x06, 0xfa, 0x6c, 0xa9, 0xbc, 0x00, 0xcd, 0xbf,
+	0x21, 0xd7, 0x40, 0x16, 0xb8, 0x44, 0x53, 0xb7,
+	0x63, 0xce, 0x66, 0x6f, 0xb6, 0x4f, 0x02, 0xa6,
+	0x2d, 0xaf, 0x9f, 0x42, 0x3e, 0x1d, 0x9e, 0x63,
+	0xb9, 0x5a, 0x2b, 0xe2, 0x1d, 0x4d, 0x23, 0xe0,
+	0x04, 0x10, 0x2f, 0x3d, 0x7f, 0x5c, 0x47, 0x4f,
+	0xe9, 0xe9, 0x32, 0x06, 0xe8, 0xab, 0x7c, 0x78,
+	0x10, 0x8c, 0x2e, 0xf5, 0xc8, 0xe1, 0x1e, 0x33,
+	0x13, 0x44, 0x2a, 0x98, 0xbd, 0xbd, 0x2c, 0x34,
+	0x28, 0x19, 0x45, 0x18, 0x35, 0x47, 0xfc, 0x54,
+	0x06, 0x9b, 0x4d, 0xad, 0x52, 0xe5, 0xd3, 0x23,
+	0xb5, 0x66, 0x87, 0x7b, 0xe8, 0x60, 0x36, 0x4f,
+	0x45, 0x8b, 0xf9, 0x29, 0xe2, 0xf3, 0x84, 0xc7,
+	0xff, 0xf2, 0x11, 0xc9, 0xb4, 0x4f, 0x0d, 0x35,
+	0x97, 0xf6, 0xcd, 0xef, 0x1b, 0x92, 0xd1, 0x38,
+	0xdd, 0x1a, 0x88, 0x84, 0x9f, 0x6f, 0xe3, 0x97,
+	0xaf, 0x8f, 0x3a, 0x5b, 0xb1, 0x4b, 0xc5, 0x29,
+	0xb7, 0xf2, 0x6a, 0x30, 0x19, 0xa7, 0x7b, 0xa3,
+	0xc0, 0x5a, 0xf7, 0x2a, 0xc2, 0x74, 0xab, 0x09,
+	0x0a, 0x33, 0x1e, 0xf5, 0x88, 0x28, 0x9a, 0xa3,
+	0xb3, 0x9e, 0x10, 0x24, 0x44, 0x24, 0xbc, 0xf0,
+	0x35, 0xb5, 0x21, 0x98, 0x58, 0x7f, 0x04, 0x1b,
+	0x1d, 0xe0, 0xb2, 0x96, 0xe4, 0xe5, 0x9a, 0x9c,
+	0xae, 0x7b, 0x2f, 0x51, 0x69, 0x77, 0x8b, 0xfc,
+	0x60, 0x12, 0xb4, 0x01, 0x35, 0xd0, 0x70, 0x98,
+	0xbb, 0x69, 0xb5, 0xb4, 0x8d, 0x5e, 0x7c, 0xb7,
+	0xb7, 0xab, 0xb7, 0x5b, 0xbb, 0x57, 0xbf, 0x08,
+	0xae, 0x18, 0x50, 0xdb, 0x74, 0x52, 0x55, 0xb1,
+	0xc5, 0xf5, 0x65, 0x45, 0xc1, 0xa6, 0xdc, 0x31,
+	0x9e, 0xd8, 0xb8, 0x16, 0xf6, 0xb7, 0x3e, 0xa5,
+	0x61, 0x70, 0x88, 0x12, 0x86, 0x3c, 0xab, 0xf3,
+	0x58, 0x8d, 0xd1, 0x5a, 0x2a, 0x67, 0xe7, 0x04,
+};
+#elif CONFIG_RSA_KEY_SIZE == 3072
+static const struct rsa_public_key key = {
+	.n = {
+		0xa6042e57, 0x1b5a0f4b, 0xbdc9d423, 0xc243e589,
+		0xc93f9ba2, 0x23cf2a9c, 0x3722092b, 0x6e8c6f6e,
+		0xb35627e6, 0x9c344bc3, 0x41112b82, 0x8f2d5224,
+		0x78de5503, 0xc2d8a717, 0xdcaac4ac, 0xf1a3e248,
+		0x025afd34, 0xb6141b4c, 0xd8d377fd, 0xc4b96b98,
+		0x06452049, 0x90e17f1f, 0xe15bf75c, 0xfe863bdb,
+		0xb40cea38, 0xdcead594, 0x6cbcfb94, 0xd8da2e91,
+		0xee2c497b, 0xd9816eb6, 0x62c5c71a, 0x548b9124,
+		0x86c9d476, 0xb3a27431, 0xd26104c8, 0x58e31d38,
+		0x01ec97a4, 0xf3b3df76, 0x24ecf07e, 0x28bf8e58,
+		0xd84843f3, 0x980aabae, 0xc623e5e0, 0x721767cb,
+		0xa49cd405, 0x45fcf322, 0x585cad1f, 0x382f5cc3,
+		0x872e7781, 0xae2626d4, 0xedda28e7, 0x68e7eba4,
+		0x0b9d74d2, 0x2da11947, 0x874d00c1, 0x496629f0,
+		0xe955baa3, 0xe6465e14, 0x8412bd87, 0x739127d7,
+		0xf0489905, 0x8351e740, 0xbed73aac, 0x09ef7535,
+		0xda818319, 0xc447ef5b, 0x54d0a46b, 0x9d996d47,
+		0x963798e6, 0x7d2ea1ad, 0x56a4de52, 0x9c7a8923,
+		0x639c174e, 0x43ceb70a, 0x6be8678e, 0x840ef90e,
+		0x59734d0b, 0x80978e60, 0x2cd82703, 0xe4788bc0,
+		0xb3df6fda, 0x3b0b1b2b, 0x912ac0df, 0xffb97744,
+		0x190fa633, 0x89b0bb09, 0xf371c7ea, 0x6c0ef8d1,
+		0x7e4ecab2, 0xb5797e95, 0x477a51dc, 0xc1d85e8b,
+		0xefa27ef9, 0xe7ec63de, 0x590aab34, 0xc272173e,
+	},
+	.rr = {
+		0xca6e587b, 0x1ebf09ed, 0xddab123e, 0xc02baac5,
+		0x81731cf7, 0xfc3ef49d, 0x9db928bc, 0xe897c58c,
+		0x82d5d8e4, 0x21a1f815, 0x62354873, 0x4e14e1da,
+		0x73a1320a, 0xb1ccb860, 0xe8d7ed27, 0x05d37798,
+		0x3f93ecb5, 0x806db24a, 0x1cbe3ec4, 0xdfd81bbc,
+		0x136a701c, 0x011e7115, 0x10f27d6c, 0x9c51b4d5,
+		0x1f11ef24, 0xfca01a3b, 0xd26c2dd3, 0xc13b5f41,
+		0xad231aa2, 0xebeb060f, 0xe0e10d46, 0x9875daf1,
+		0x102578a6, 0xbdf02004, 0x548f4e70, 0xc15be91a,
+		0x41496b0d, 0x508ad6c7, 0x1bd84d3d, 0x42af52f9,
+		0xf993e16e, 0x65c24fe8, 0x0765ba9b, 0x570762c9,
+		0x145f12ea, 0xdd83ab5e, 0x8496cd3d, 0x7851a734,
+		0xc258c438, 0x57470474, 0x8e2b1371, 0xe647f2d7,
+		0x4dd617b8, 0x1535558e, 0xf24838b8, 0x186f265a,
+		0xaabae333, 0xf09c17b6, 0xbb1d7d10, 0x8daff259,
+		0x1cb41127, 0xa6c4b0b1, 0xaa629cf5, 0x7d4ae174,
+		0xeb6e5d9b, 0xf4f2d9ee, 0x38d1197f, 0x33cafa00,
+		0xb6017921, 0xd23182a3, 0x88646ee2, 0x0a7ce2a4,
+		0xa5fb078c, 0x0e9f7d25, 0xbda6ffa5, 0x59177062,
+		0xef6c0aae, 0xcb44189d, 0xdc4766a7, 0xafa626b3,
+		0xc824b141, 0xa860e473, 0x08ac14ff, 0x30c5b610,
+		0x159b3bee, 0x10be8403, 0xe8253000, 0xe5e8319e,
+		0xefe4782d, 0x97407128, 0x87d2b9bf, 0x61394714,
+		0x3e043108, 0x51374fa4, 0x28da0043, 0x353f5316,
+	},
+	.n0inv = 0x00756299,
+};
+
+static const uint8_t signature[RSANUMBYTES] = {
+	0x38, 0x61, 0xaa, 0x7f, 0x33, 0x9b, 0x29, 0x01,
+	0x30, 0xbb, 0xf1, 0xa5, 0x23, 0xd5, 0x5b, 0x7e,
+	0x0d, 0xc3, 0x74, 0x0a, 0xd7, 0x48, 0x97, 0x34,
+	0x50, 0x38, 0x35, 0xaa, 0x29, 0xd1, 0xee, 0x99,
+	0x5b, 0x23, 0x22, 0x2e, 0x3d, 0xed, 0x52, 0x4d,
+	0xd7, 0x11, 0xbf, 0x1a, 0x65, 0x78, 0x23, 0x11,
+	0xa9, 0x34, 0x10, 0x93, 0xd6, 0xe0, 0xf8, 0x7f,
+	0x92, 0x39, 0x70, 0x65, 0xb2, 0xfa, 0xfa, 0x13,
+	0x9f, 0x63, 0xf7, 0xfb, 0x31, 0xe9, 0x47, 0x40,
+	0x65, 0x8c, 0x68, 0xa2, 0x99, 0x8f, 0x28, 0x95,
+	0x09, 0x69, 0xe0, 0x81, 0xfc, 0x42, 0x22, 0xa8,
+	0x5b, 0xe4, 0xef, 0xc4, 0xac, 0x9f, 0x5d, 0x4b,
+	0xd3, 0x5b, 0x74, 0x05, 0xa4, 0xb9, 0xe2, 0xec,
+	0xde, 0x3e, 0x6a, 0xe8, 0x21, 0xd4, 0x71, 0xb7,
+	0x7c, 0x85, 0xec, 0x98, 0x73, 0xd9, 0xce, 0x33,
+	0x2c, 0x17, 0xbc, 0xb4, 0xfd, 0xe1, 0x90, 0x94,
+	0x91, 0x04, 0xd2, 0xfd, 0x2d, 0x3f, 0xb0, 0xa8,
+	0xcb, 0xdd, 0x2b, 0x64, 0xbc, 0x98, 0x2c, 0x16,
+	0xe3, 0x24, 0x1d, 0x56, 0xc0, 0x21, 0xfd, 0xe1,
+	0x1f, 0xbe, 0xa8, 0xdf, 0x5e, 0x27, 0xf0, 0x2a,
+	0x63, 0x0b, 0xa2, 0xa8, 0xde, 0x1a, 0xea, 0xfb,
+	0x7c, 0xea, 0x78, 0x92, 0xf6, 0xfb, 0xe4, 0xfb,
+	0xd5, 0x70, 0xfa, 0x45, 0xf2, 0x2d, 0x42, 0x76,
+	0x80, 0x84, 0x6b, 0x29, 0xf4, 0x07, 0x61, 0xaa,
+	0x55, 0x60, 0x2c, 0xd3, 0x00, 0x57, 0x8b, 0xd2,
+	0x2c, 0xc0, 0xbd, 0xdb, 0x1a, 0xa1, 0x5a, 0xc1,
+	0xd5, 0x24, 0x3a, 0xb3, 0x09, 0xf8, 0x4e, 0x28,
+	0xbd, 0xcc, 0x7b, 0xc8, 0x3a, 0x42, 0x6a, 0x4e,
+	0xef, 0x69, 0xab, 0x45, 0x3c, 0xd0, 0x6e, 0xf6,
+	0xfc, 0x8a, 0x1c, 0xb5, 0x13, 0x9b, 0x03, 0x50,
+	0x47, 0x5e, 0x07, 0x18, 0x51, 0x33, 0x81, 0xdd,
+	0x6c, 0x5c, 0xcc, 0xd1, 0xae, 0x04, 0xc9, 0x81,
+	0x74, 0xc3, 0x1f, 0xae, 0xcc, 0xa0, 0x58, 0x61,
+	0x5e, 0x67, 0x73, 0x18, 0x1c, 0x29, 0x56, 0xa3,
+	0xe2, 0xa6, 0x2f, 0x9c, 0xa4, 0x64, 0xe2, 0xd9,
+	0x27, 0x9b, 0xc3, 0x60, 0x62, 0x8c, 0x5e, 0xbc,
+	0xb7, 0xe7, 0xdd, 0xa2, 0xc9, 0xa9, 0xf0, 0xfb,
+	0x8b, 0x61, 0xc6, 0x6e, 0x1a, 0xeb, 0x33, 0x3f,
+	0xcc, 0x97, 0x2a, 0x67, 0xe7, 0x74, 0xc1, 0x35,
+	0xe3, 0xea, 0x72, 0x5a, 0x0f, 0x45, 0x84, 0xed,
+	0x18, 0xa0, 0x62, 0xdb, 0x41, 0x39, 0x12, 0xc5,
+	0x9e, 0xdf, 0xf1, 0x15, 0xc2, 0xcc, 0x6b, 0x87,
+	0xe4, 0x9d, 0x51, 0x1d, 0x1d, 0x65, 0xde, 0x50,
+	0xaa, 0x7e, 0xdb, 0xca, 0x52, 0x3e, 0xe2, 0x2a,
+	0xf0, 0x04, 0xdc, 0x7a, 0x3a, 0x1e, 0x75, 0x32,
+	0x54, 0x39, 0xb0, 0x7f, 0xcd, 0x1a, 0x22, 0x3a,
+	0x33, 0x3b, 0x2d, 0x87, 0x40, 0x4e, 0x0e, 0xad,
+	0xc5, 0x41, 0x31, 0x04, 0xc0, 0xc9, 0x87, 0x5e,
+};
+#elif CONFIG_RSA_KEY_SIZE == 4096
+static const struct rsa_public_key key = {
+	.n = {
+		0xc0320c23, 0x154b7a01, 0x711b24a3, 0x078b15f2,
+		0x71538ffb, 0x779b31b3, 0x1709c172, 0xf08c9ffe,
+		0xd507fbde, 0x9991e163, 0xab8848b1, 0x533f6c90,
+		0x285f4b03, 0x2cb0b638, 0xebd6bfb4, 0x9d8f3c27,
+		0xa6eb7cc7, 0xe7fe92a5, 0xe78f07cf, 0x42b29bb5,
+		0x54699d6b, 0x1ace9b46, 0x4c922265, 0x5b135549,
+		0xed961929, 0x4783bd94, 0x3c3bee94, 0x18b46164,
+		0xd2bfda6e, 0xe57b3e08, 0x3aa3fa5f, 0xf2028d9b,
+		0x2ea6d125, 0x61e6e814, 0xb8c2f37b, 0x3bf3bbee,
+		0x50cea707, 0xbb2332a0, 0x3a595029, 0xe2deb3c6,
+		0x598780e6, 0x61934773, 0x03729bac, 0x2cb6b1b2,
+		0xbc0bba14, 0x7da93e6d, 0xc49fb1ed, 0x3f3f4899,
+		0x84d2f495, 0xbf422dbe, 0xff99032c, 0x86e05f79,
+		0x49e444f7, 0x5e916cd7, 0x68860f96, 0xdcabed79,
+		0x287075af, 0x4b76b8b6, 0x9557f0e6, 0xc4fa90e5,
+		0x3269f3d4, 0x0641ae03, 0xbba4835b, 0x7ba1773c,
+		0x3d76eadc, 0xad05bade, 0x84703649, 0x04540f73,
+		0x501a85eb, 0x1aa92af1, 0x69ddbb97, 0x0afda30f,
+		0x4168394f, 0xb2d505e1, 0x9246d342, 0x4fbb0e25,
+		0x81131f61, 0xe37dd60d, 0xe162321d, 0xb1b14d00,
+		0x8972aa79, 0x69ae25d7, 0x089dd086, 0x95576a66,
+		0x80119404, 0x14549899, 0xae735cbd, 0x7d4f0846,
+		0x59d4ede5, 0x67258052, 0x1ee175b1, 0x39ef34b8,
+		0xfdf17e65, 0x237eb233, 0x322d9633, 0x3847cfcb,
+		0x2336a0da, 0x65473a5a, 0x2b47a9f5, 0x4b72cdd9,
+		0x2bcc6a38, 0xdeec3bee, 0xa2fcba95, 0xf6c8f151,
+		0x800a66d5, 0x8bd3f1e7, 0x44faeeb6, 0x65c60f68,
+		0xdfc005d6, 0xc7efe8ab, 0xb6d772e0, 0x77589ed2,
+		0xbdad7689, 0x0e16e569, 0xf6b95e8e, 0x771b48b8,
+		0xaab1bd62, 0xecf9d4f2, 0xcb80259a, 0x099cb860,
+		0x053fedf1, 0x750374cb, 0x292115a9, 0x3e563d50,
+		0xfe24c6b4, 0xe44d6e53, 0x9a889941, 0xabc6d2fb,
+	},
+	.rr = {
+		0x60292ac7, 0xf46057f6, 0xeb05f482, 0x8f0fa2d7,
+		0xb274ceb0, 0xc9f91b23, 0x13b85076, 0x3bf3c66a,
+		0x3106e982, 0x02acf825, 0xe91b9b3f, 0x3c08600e,
+		0x38e2d7ac, 0x536b7777, 0x34e056b6, 0x525868dc,
+		0xcc29ca47, 0x8d956bc6, 0x72d32c57, 0xc807d838,
+		0xd6eacf15, 0xdd1c063b, 0xc08ba255, 0x05040cd7,
+		0xc4f5181a, 0x5b0371f2, 0x80536c11, 0x83a6806f,
+		0x9c2a111c, 0x2d242ba3, 0x7aff1f84, 0xc1ccbb5d,
+		0x457e9cc3, 0x9cde62da, 0xc0ac418f, 0x456d5798,
+		0xd3137e28, 0x7e1c816e, 0x6e31ebb2, 0x297475f0,
+		0x85b35d78, 0xf6bd5d5b, 0xad6c290f, 0xfec4ff87,
+		0xc4fb9d72, 0x019ae90f, 0x2ab4143b, 0xc9e17436,
+		0x8ece7d06, 0xb1e181b9, 0xa8540e7c, 0xb5d4bc97,
+		0x1344baff, 0x0d3a0925, 0xe944d0c7, 0x3b32944b,
+		0x031e4a85, 0x6caa9c4d, 0x64e7e545, 0x548e0001,
+		0x4a700b68, 0x8de472e8, 0x636b756e, 0xf9d80248,
+		0x232debfa, 0x54919b51, 0x7c4ffb37, 0x66badf27,
+		0x69186c1f, 0x4465c486, 0xeea8f404, 0xe8313ab4,
+		0x0743b7b2, 0xa2f6c25f, 0xaf128ce2, 0x9068b378,
+		0x0aa5ce96, 0x28cf97d9, 0xb973ca3d, 0xeca02eee,
+		0x4539178e, 0x8fafaf86, 0xd34a7d19, 0x0c3dbc26,
+		0xcb677846, 0x8935a799, 0xdc07a0f4, 0xd93d8c63,
+		0x8b1eb1ab, 0x95cdfd77, 0xc193d095, 0x6aec6d3e,
+		0xf9b39d30, 0xdd28a186, 0x5b9e063e, 0x70c18b08,
+		0x362089b7, 0xb735a4cf, 0x4474e73c, 0x7432744b,
+		0xfc1c21c4, 0x9235e75d, 0x0785e05d, 0xcf699c7a,
+		0xbe36eef7, 0x5e8e8558, 0xb6b0b52d, 0x9090844e,
+		0xcf8dc7fe, 0xf6dbb8ce, 0x2d11023c, 0x4d987ae8,
+		0x9f05d761, 0xb3fa4008, 0x5adf2cbd, 0xf58a1d17,
+		0xe6be98c4, 0x011743b3, 0x21586029, 0x535c3f86,
+		0x3bfb1904, 0x60aef784, 0xf5f11380, 0xa62801fd,
+		0x35b2a82a, 0x7d04a31e, 0xffa8b3ba, 0x236e4112,
+	},
+	.n0inv = 0xf9fafc75,
+};
+
+static const uint8_t signature[RSANUMBYTES] = {
+	0x70, 0xf5, 0x6e, 0x05, 0x97, 0x20, 0xd3, 0x4d,
+	0xb3, 0x63, 0xa4, 0x49, 0x45, 0x02, 0xa2, 0xe8,
+	0x78, 0xcb, 0x5b, 0x6b, 0xd6, 0xfe, 0xcd, 0xb2,
+	0x9e, 0x0d, 0x41, 0xfb, 0xdf, 0x14, 0x77, 0x33,
+	0xd6, 0x60, 0x83, 0x5e, 0x23, 0x0a, 0xf2, 0xaa,
+	0x52, 0x19, 0x60, 0x29, 0xb9, 0xb8, 0x99, 0x00,
+	0x80, 0x3f, 0xa2, 0x62, 0xdf, 0x86, 0xcc, 0xef,
+	0xca, 0x31, 0x85, 0xf1, 0xda, 0x4a, 0x1b, 0xb3,
+	0xec, 0x2f, 0xe3, 0x73, 0xce, 0xf5, 0x38, 0xb0,
+	0xde, 0x62, 0x39, 0x54, 0xec, 0xa0, 0x78, 0x66,
+	0xc1, 0x42, 0x5e, 0x58, 0x0d, 0xd7, 0x68, 0xce,
+	0x92, 0x7b, 0x1c, 0xf8, 0x29, 0xed, 0x38, 0xcd,
+	0xa0, 0xc6, 0xaa, 0x8a, 0xe6, 0x7e, 0x64, 0x80,
+	0x3b, 0x44, 0x53, 0x77, 0x3e, 0x78, 0x14, 0xce,
+	0x6b, 0x8e, 0x28, 0x86, 0xf3, 0x31, 0x1b, 0xc2,
+	0x65, 0xfb, 0xd0, 0x3c, 0xef, 0x92, 0x89, 0xfa,
+	0x3c, 0xdd, 0x43, 0x4e, 0x9a, 0x9f, 0x2f, 0xad,
+	0xef, 0x48, 0x0e, 0x6e, 0x89, 0xc7, 0x97, 0x83,
+	0x90, 0xc6, 0x6e, 0xb9, 0x51, 0x45, 0xc7, 0xf5,
+	0xfd, 0x09, 0x8e, 0x4e, 0x37, 0x37, 0xd4, 0xe4,
+	0x6f, 0x20, 0x12, 0x14, 0x45, 0xdf, 0x17, 0x7e,
+	0xb3, 0x05, 0x36, 0xc2, 0xa4, 0x85, 0xda, 0x0a,
+	0x9e, 0x28, 0x09, 0x59, 0xbd, 0xcd, 0x2a, 0xbc,
+	0xf5, 0xc2, 0x7d, 0x4d, 0xdc, 0x14, 0x9f, 0xd4,
+	0x4c, 0x97, 0xf2, 0x5b, 0xc1, 0x53, 0x3b, 0xe7,
+	0xfc, 0x7c, 0xf3, 0x1a, 0xf2, 0x2b, 0xa6, 0x6b,
+	0x38, 0xaa, 0xdd, 0xec, 0xa5, 0x04, 0x27, 0xe8,
+	0xe1, 0x53, 0x85, 0xf3, 0x28, 0x21, 0x08, 0x5e,
+	0xef, 0xbc, 0x97, 0xc6, 0x00, 0xa4, 0x8a, 0xac,
+	0x8e, 0x73, 0xcd, 0x17, 0xeb, 0xac, 0x1d, 0x1b,
+	0x8e, 0x78, 0x6b, 0x3c, 0x36, 0x0d, 0xd4, 0x91,
+	0x9d, 0x0c, 0xce, 0x85, 0x73, 0x6f, 0xbd, 0x37,
+	0x6a, 0x76, 0x18, 0x90, 0xc3, 0x39, 0x35, 0x83,
+	0xc0, 0x94, 0x9b, 0xa4, 0x37, 0x84, 0x67, 0xa0,
+	0xd0, 0xa8, 0x2d, 0xd8, 0x1e, 0x41, 0x6b, 0xd0,
+	0xbe, 0xcf, 0xc7, 0x92, 0x03, 0x39, 0x49, 0xdd,
+	0x96, 0x02, 0x6f, 0x0f, 0x3e, 0xc9, 0xeb, 0xc9,
+	0xe0, 0xc2, 0xb7, 0x85, 0xc7, 0xa5, 0x08, 0xbf,
+	0xa9, 0xf5, 0x4f, 0x57, 0xdf, 0x4f, 0xca, 0x6e,
+	0x66, 0xad, 0x60, 0xcc, 0x7b, 0x7f, 0x26, 0x0c,
+	0x5e, 0x51, 0xd8, 0xb6, 0x42, 0x4e, 0x25, 0xd8,
+	0x65, 0x4a, 0x0e, 0x96, 0xd9, 0x99, 0x2b, 0x65,
+	0xe6, 0x68, 0x6e, 0x61, 0x6c, 0x80, 0x87, 0xc8,
+	0xe6, 0x81, 0xe6, 0x19, 0x32, 0x49, 0x8e, 0x1b,
+	0x02, 0x56, 0xc0, 0xe2, 0xa5, 0xeb, 0xee, 0xaf,
+	0x96, 0x84, 0xde, 0x22, 0xca, 0xd1, 0xa3, 0x7b,
+	0xa0, 0x3d, 0x72, 0x9b, 0xbc, 0x59, 0x94, 0xb1,
+	0x04, 0xdd, 0x9f, 0xd6, 0x76, 0x82, 0xe3, 0x85,
+	0xd4, 0x7f, 0x0c, 0x1e, 0x13, 0xc3, 0x58, 0x8a,
+	0x4e, 0x89, 0x5a, 0x61, 0xf3, 0x08, 0x5f, 0xa7,
+	0x9a, 0x1d, 0xe9, 0xd0, 0x64, 0x18, 0xba, 0xbd,
+	0x2e, 0x8c, 0xa6, 0xf3, 0x8b, 0x1c, 0x08, 0x8d,
+	0xce, 0xc0, 0x2c, 0xca, 0x73, 0x17, 0x8e, 0x18,
+	0x52, 0xf0, 0x99, 0xd6, 0x35, 0x3b, 0x51, 0x6c,
+	0x31, 0x0a, 0x1e, 0x86, 0x86, 0xb7, 0x04, 0xb6,
+	0x04, 0xb1, 0xa8, 0xce, 0x25, 0xb2, 0x3c, 0x3b,
+	0xa8, 0x7d, 0x97, 0x42, 0xb3, 0x30, 0xe7, 0x5b,
+	0x56, 0xc5, 0x3e, 0x91, 0x5a, 0x73, 0x9b, 0x9c,
+	0x6a, 0xe5, 0x1c, 0xb1, 0xf0, 0xd2, 0x26, 0xb3,
+	0xc4, 0xdb, 0x91, 0x66, 0x8b, 0xb3, 0x6f, 0x6b,
+	0x0b, 0x1b, 0xd5, 0xc5, 0x33, 0xcd, 0x96, 0x16,
+	0x1a, 0x9d, 0x5f, 0x62, 0xed, 0x98, 0x35, 0x36,
+	0x74, 0x5e, 0x92, 0x72, 0x81, 0x21, 0xe4, 0xc7,
+	0x7e, 0xee, 0x5a, 0x38, 0xd6, 0xb0, 0x2c, 0x1d,
+};
+#endif
+
+#endif  /* __TEST_RSA_BENCH_KEYS_H */
@@ -0,0 +1,64 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Timed ping-pong between tasks, reporting context switches per second.
+ */
+#include "common.h"
+#include "console.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+#define SWITCH_COUNT 100000
+
+static int switch_count;
+
+int task_ping(void *data)
+{
+	task_id_t next = task_get_current() + 1;
+	uint64_t start, elapsed;
+
+	if (next > TASK_ID_PONGB)
+		next = TASK_ID_PING;
+
+	task_wait_event(-1);
+
+	start = get_wall_time_us();
+	while (switch_count < SWITCH_COUNT) {
+		switch_count++;
+		task_set_event(next, TASK_EVENT_WAKE, 1);
+	}
+	elapsed = get_wall_time_us() - start;
+
+	test_print_rate(switch_count, "context switches", "switches", elapsed);
+	test_pass();
+
+	while (1)
+		task_wait_event(-1);
+
+	return EC_SUCCESS;
+}
+
+int task_pong(void *data)
+{
+	task_id_t next = task_get_current() + 1;
+
+	if (next > TASK_ID_PONGB)
+		next = TASK_ID_PING;
+
+	while (1) {
+		task_wait_event(-1);
+		switch_count++;
+		task_set_event(next, TASK_EVENT_WAKE, 0);
+	}
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	wait_for_task_started();
+	task_wake(TASK_ID_PING);
+}
@@ -0,0 +1,136 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * SHA-256 test, reporting hash throughput.
+ */
+#include "common.h"
+#include "console.h"
+#include "sha256.h"
+#include "test_util.h"
+#include "util.h"
+
+#define BENCH_SIZE (32 * 1024 * 1024)
+
+static uint8_t data[0x10000 + 1];
+
+static const uint8_t *hash_string(struct sha256_ctx *ctx, const char *s)
+{
+	SHA256_init(ctx);
+	SHA256_update(ctx, (const uint8_t *)s, strlen(s));
+	return SHA256_final(ctx);
+}
+
+static int test_known_answers(void)
+{
+	/* From FIPS 180-2 appendix B */
+	static const uint8_t abc[SHA256_DIGEST_SIZE] = {
+		0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad};
+	static const uint8_t two_blocks[SHA256_DIGEST_SIZE] = {
+		0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+		0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+		0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+		0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1};
+	static const uint8_t million_a[SHA256_DIGEST_SIZE] = {
+		0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+		0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+		0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+		0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0};
+	struct sha256_ctx ctx;
+	const uint8_t *digest;
+	int i;
+
+	digest = hash_string(&ctx, "abc");
+	TEST_ASSERT_ARRAY_EQ(digest, abc, sizeof(abc));
+	digest = hash_string(&ctx, "abcdbcdecdefdefgefghfghighijhijkijkljklm"
+			     "klmnlmnomnopnopq");
+	TEST_ASSERT_ARRAY_EQ(digest, two_blocks, sizeof(two_blocks));
+
+	/* In pieces which don't line up with the blocks */
+	memset(data, 'a', 1000);
+	SHA256_init(&ctx);
+	for (i = 0; i < 1000; i++)
+		SHA256_update(&ctx, data, 1000);
+	digest = SHA256_final(&ctx);
+	TEST_ASSERT_ARRAY_EQ(digest, million_a, sizeof(million_a));
+
+	return EC_SUCCESS;
+}
+
+static int test_update_sizes(void)
+{
+	struct sha256_ctx ctx;
+	uint8_t expect[SHA256_DIGEST_SIZE];
+	const uint8_t *digest;
+	int size = 4096 + 37;
+	int pos, len;
+	int i;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = i * 7 + (i >> 8);
+
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, data, size);
+	memcpy(expect, SHA256_final(&ctx), sizeof(expect));
+
+	/* The same data in pieces of every size up to a few blocks */
+	for (i = 1; i <= 3 * SHA256_BLOCK_SIZE; i++) {
+		SHA256_init(&ctx);
+		for (pos = 0; pos < size; pos += len) {
+			len = MIN(i, size - pos);
+			SHA256_update(&ctx, data + pos, len);
+		}
+		digest = SHA256_final(&ctx);
+		TEST_ASSERT_ARRAY_EQ(digest, expect, sizeof(expect));
+	}
+
+	/* Data which isn't word-aligned */
+	memmove(data + 1, data, size);
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, data + 1, size);
+	digest = SHA256_final(&ctx);
+	TEST_ASSERT_ARRAY_EQ(digest, expect, sizeof(expect));
+
+	return EC_SUCCESS;
+}
+
+static void hash_rate(const char *what, int update_size)
+{
+	struct sha256_ctx ctx;
+	uint64_t start;
+	int i;
+
+	start = get_wall_time_us();
+	SHA256_init(&ctx);
+	for (i = 0; i < BENCH_SIZE; i += update_size)
+		SHA256_update(&ctx, data, update_size);
+	SHA256_final(&ctx);
+	test_print_rate(BENCH_SIZE >> 20, what, "MB",
+			get_wall_time_us() - start);
+}
+
+static int test_hash_rate(void)
+{
+#ifdef CONFIG_SHA256_UNROLLED
+	ccprintf("Unrolled rounds\n");
+#endif
+	hash_rate("MB in 64 byte updates", 64);
+	hash_rate("MB in 1 KB updates", 1024);
+	hash_rate("MB in 64 KB updates", 0x10000);
+
+	return EC_SUCCESS;
+}
+
+void run_test(void)
+{
+	test_reset();
+
+	RUN_TEST(test_known_answers);
+	RUN_TEST(test_update_sizes);
+	RUN_TEST(test_hash_rate);
+
+	test_print_result();
+}
@@ -23,6 +23,24 @@
 #define CONFIG_BACKLIGHT_REQ_GPIO GPIO_PCH_BKLTEN
 #endif
 
+#ifdef TEST_CONSOLE_BINLOG
+#define CONFIG_CONSOLE_BINLOG
+#undef CONFIG_CONSOLE_BINLOG_SIZE
+#define CONFIG_CONSOLE_BINLOG_SIZE 512
+#endif
+
+#ifdef TEST_HOST_COMMAND
+#define CONFIG_HOST_COMMAND_STATUS
+#define CONFIG_HOSTCMD_BATCH
+#define CONFIG_HOSTCMD_STATS
+#endif
+
+#ifdef TEST_HOOKS
+#define CONFIG_HOOK_DEBUG
+#undef DEFERRABLE_MAX_COUNT
+#define DEFERRABLE_MAX_COUNT 80
+#endif
+
 #ifdef TEST_KB_8042
 #define CONFIG_KEYBOARD_PROTOCOL_8042
 #endif
@@ -45,6 +63,10 @@
 #define CONFIG_LID_ANGLE_SENSOR_LID 1
 #endif
 
+#ifdef TEST_PINGPONG
+#define CONFIG_TASK_STATS
+#endif
+
 #ifdef TEST_SBS_CHARGING
 #define CONFIG_BATTERY_MOCK
 #define CONFIG_BATTERY_SMART
@@ -116,6 +138,27 @@ int bd99992gw_get_temp(uint16_t adc);
 #define CONFIG_SW_CRC
 #endif
 
+#if defined(TEST_RSA_BENCH) || defined(TEST_RSA3072_BENCH) || \
+	defined(TEST_RSA4096_BENCH)
+#define CONFIG_RSA
+#endif
+
+#ifdef TEST_RSA3072_BENCH
+#define CONFIG_RSA_KEY_SIZE 3072
+#endif
+
+#ifdef TEST_RSA4096_BENCH
+#define CONFIG_RSA_KEY_SIZE 4096
+#endif
+
+#if defined(TEST_SHA256_BENCH) || defined(TEST_SHA256_UNROLLED_BENCH)
+#define CONFIG_SHA256
+#endif
+
+#ifdef TEST_SHA256_UNROLLED_BENCH
+#define CONFIG_SHA256_UNROLLED
+#endif
+
 #ifdef TEST_CHARGE_MANAGER
 #define CONFIG_CHARGE_MANAGER
 #define CONFIG_USB_PD_DUAL_ROLE
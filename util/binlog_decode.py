@@ -0,0 +1,243 @@
+#!/usr/bin/env python
+# Copyright 2015 The Chromium OS Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+"""Decode the EC binary console log.
+
+The log holds format string addresses and raw arguments; the format strings
+themselves are looked up in the EC image the log came from.
+
+  Example:
+    ectool consolebinlog /tmp/binlog
+    util/binlog_decode.py build/samus_pd/RW/ec.RW.elf /tmp/binlog
+"""
+
+from __future__ import print_function
+
+import optparse
+import struct
+import sys
+
+# Must match include/ec_commands.h
+HEADER_WORDS = 4
+FLAG_TIMESTAMP = 1 << 16
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+class DecodeError(Exception):
+  """Exception class for binlog_decode."""
+
+
+class ElfImage(object):
+  """Reads null-terminated strings from the loaded sections of an ELF file."""
+
+  def __init__(self, filename):
+    with open(filename, 'rb') as f:
+      self._data = f.read()
+    if self._data[:4] != b'\x7fELF':
+      raise DecodeError('%s is not an ELF file' % filename)
+
+    elf_class = bytearray(self._data[4:5])[0]
+    endian = '<' if bytearray(self._data[5:6])[0] == 1 else '>'
+    if elf_class == 1:
+      shoff, = struct.unpack_from(endian + 'I', self._data, 0x20)
+      shentsize, shnum = struct.unpack_from(endian + 'HH', self._data, 0x2e)
+      section = endian + 'IIIIII'
+    else:
+      shoff, = struct.unpack_from(endian + 'Q', self._data, 0x28)
+      shentsize, shnum = struct.unpack_from(endian + 'HH', self._data, 0x3a)
+      section = endian + 'IIQQQQ'
+
+    # (address, file offset, size) of each section with contents
+    self._sections = []
+    for i in range(shnum):
+      _, sh_type, flags, addr, offset, size = struct.unpack_from(
+          section, self._data, shoff + i * shentsize)
+      if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size:
+        self._sections.append((addr, offset, size))
+
+  def string(self, addr):
+    for start, offset, size in self._sections:
+      if start <= addr < start + size:
+        begin = offset + addr - start
+        end = self._data.index(b'\0', begin, offset + size)
+        return self._data[begin:end].decode('latin-1')
+    raise DecodeError('no format string at 0x%08x' % addr)
+
+
+class Record(object):
+  """The arguments of one record, consumed in format string order."""
+
+  def __init__(self, words):
+    self._words = words
+    self._next = HEADER_WORDS
+
+  def word(self):
+    w = self._words[self._next]
+    self._next += 1
+    return w
+
+  def data(self):
+    size = self.word()
+    raw = struct.pack('<%dI' % ((size + 3) // 4),
+                      *self._words[self._next:self._next + (size + 3) // 4])
+    self._next += (size + 3) // 4
+    return bytearray(raw[:size])
+
+
+def to_base(v, base, upper):
+  digits = '0123456789ABCDEF' if upper else '0123456789abcdef'
+  s = ''
+  while True:
+    v, d = divmod(v, base)
+    s = digits[d] + s
+    if not v:
+      return s
+
+
+def format_int(conv, v, is_64bit, precision):
+  """Convert an integer like vfnprintf(), including fixed point."""
+  bits = 64 if is_64bit else 32
+  negative = conv == 'd' and v >> (bits - 1)
+  if negative:
+    v = (1 << bits) - v
+
+  base = {'x': 16, 'X': 16, 'p': 16, 'b': 2}.get(conv, 10)
+  frac = ''
+  for _ in range(precision):
+    v, d = divmod(v, 10)
+    frac = str(d) + frac
+  s = to_base(v, base, conv == 'X')
+  if precision:
+    s += '.' + frac
+  return '-' + s if negative else s
+
+
+def pad(s, left, zero, width, precision):
+  """Pad and truncate a field like vfnprintf()."""
+  if precision > 0 and width > precision:
+    width = precision
+  if not precision:
+    precision = max(len(s), width)
+  fill = max(width - len(s), 0)
+  if left:
+    return s[:precision] + ' ' * fill
+  return ('0' if zero else ' ') * fill + s[:precision]
+
+
+def format_record(fmt, words):
+  """Format one record, following vfnprintf() in common/printf.c."""
+  record = Record(words)
+  out = []
+  if words[0] & FLAG_TIMESTAMP:
+    out.append('[%s ' % format_int('u', words[2] | words[3] << 32, True, 6))
+
+  fmt += '\0'
+  i = 0
+  while fmt[i] != '\0':
+    c = fmt[i]
+    i += 1
+    if c != '%':
+      out.append(c)
+      continue
+
+    c = fmt[i]
+    i += 1
+    if c in '%\0':
+      out.append('%')
+      if c == '\0':
+        break
+      continue
+    if c == 'c':
+      out.append(chr(record.word() & 0xff))
+      continue
+
+    left = zero = False
+    width = precision = 0
+    if c == '-':
+      left = True
+      c, i = fmt[i], i + 1
+    if c == '0':
+      zero = True
+      c, i = fmt[i], i + 1
+    if c == '*':
+      width = struct.unpack('<i', struct.pack('<I', record.word()))[0]
+      c, i = fmt[i], i + 1
+    while c.isdigit():
+      width = width * 10 + int(c)
+      c, i = fmt[i], i + 1
+    if c == '.':
+      c, i = fmt[i], i + 1
+      if c == '*':
+        precision = struct.unpack('<i', struct.pack('<I', record.word()))[0]
+        c, i = fmt[i], i + 1
+      while c.isdigit():
+        precision = precision * 10 + int(c)
+        c, i = fmt[i], i + 1
+    is_64bit = c == 'l'
+    if is_64bit:
+      c, i = fmt[i], i + 1
+
+    if c == 's':
+      s = record.data()
+      out.append(pad(s[:-1].decode('latin-1'), left, zero, width, precision))
+    elif c == 'h':
+      out.append(''.join('%02x' % b for b in record.data()))
+    elif c == 'T':
+      out.append(pad(format_int('u', words[2] | words[3] << 32, True, 6),
+                     left, zero, width, 0))
+    elif c in 'duxXpb' and c != '\0':
+      v = record.word()
+      if is_64bit:
+        v |= record.word() << 32
+      out.append(pad(format_int(c, v, is_64bit, precision),
+                     left, zero, width, 0))
+    else:
+      out.append('ERROR')
+      break
+
+  if words[0] & FLAG_TIMESTAMP:
+    out.append(']\n')
+  return ''.join(out)
+
+
+def decode(image, log):
+  """Yield the formatted text of each record in a saved log."""
+  if len(log) % 4:
+    raise DecodeError('log size is not a whole number of words')
+  words = struct.unpack('<%dI' % (len(log) // 4), log)
+  format_base = words[0]
+  pos = 1
+  while pos < len(words):
+    size = words[pos] & 0xff
+    if not size or pos + size > len(words):
+      raise DecodeError('bad record at word %d' % pos)
+    record = words[pos:pos + size]
+    offset = struct.unpack('<i', struct.pack('<I', record[1]))[0]
+    fmt = image.string((format_base + offset) & 0xffffffff)
+    yield format_record(fmt, record)
+    pos += size
+
+
+def main():
+  parser = optparse.OptionParser(usage='%prog <ec.elf> <log file>')
+  (_, args) = parser.parse_args()
+  if len(args) != 2:
+    parser.error('Must supply the EC image and the log file.')
+
+  image = ElfImage(args[0])
+  with open(args[1], 'rb') as f:
+    log = f.read()
+
+  try:
+    for text in decode(image, log):
+      sys.stdout.write(text)
+  except DecodeError as e:
+    sys.stderr.write('%s\n' % e)
+    sys.exit(1)
+
+
+if __name__ == '__main__':
+  main()
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "comm-host.h"
 #include "ec_commands.h"
@@ -28,6 +29,7 @@ static int command_offset;
 int comm_init_dev(const char *device_name) __attribute__((weak));
 int comm_init_lpc(void) __attribute__((weak));
 int comm_init_i2c(void) __attribute__((weak));
+int comm_init_socket(void) __attribute__((weak));
 
 static int fake_readmem(int offset, int bytes, void *dest)
 {
@@ -77,6 +79,231 @@ int ec_command(int command, int version,
 				indata, insize);
 }
 
+/* Cleared if the EC turns out not to support EC_CMD_BATCH */
+static int batch_supported = 1;
+
+/**
+ * Send one command of a batch by itself.
+ *
+ * @return 1, or negative if communication failed.
+ */
+static int send_one(struct ec_batch_cmd *cmd)
+{
+	cmd->rv = ec_command(cmd->command, cmd->version,
+			     cmd->outdata, cmd->outsize,
+			     cmd->indata, cmd->insize);
+
+	/* An error result from the EC still means the command was sent */
+	return cmd->rv < 0 && cmd->rv > -EECRESULT ? cmd->rv : 1;
+}
+
+/**
+ * Send as many commands as fit in one batch.
+ *
+ * @return The number of commands run, or negative if communication failed.
+ */
+static int send_batch(struct ec_batch_cmd *cmds, int count)
+{
+	int out_max = ec_max_outsize;
+	int in_max = ec_max_insize;
+	struct ec_params_batch *p;
+	struct ec_response_batch *r;
+	uint8_t *out, *in;
+	int out_size = sizeof(*p), in_size = sizeof(*r);
+	int i, n, rv;
+
+	out = calloc(1, out_max);
+	in = malloc(in_max);
+	if (!out || !in) {
+		free(out);
+		free(in);
+		return -ENOMEM;
+	}
+
+	p = (struct ec_params_batch *)out;
+	for (n = 0; n < count && n < 0xff; n++) {
+		struct ec_batch_request *req =
+			(struct ec_batch_request *)(out + out_size);
+
+		if (out_size + sizeof(*req) +
+		    EC_BATCH_ALIGN(cmds[n].outsize) > out_max ||
+		    in_size + sizeof(struct ec_batch_response) +
+		    EC_BATCH_ALIGN(cmds[n].insize) > in_max)
+			break;
+
+		req->command = cmds[n].command;
+		req->version = cmds[n].version;
+		req->size = cmds[n].outsize;
+		req->response_max = cmds[n].insize;
+		memcpy(req + 1, cmds[n].outdata, cmds[n].outsize);
+
+		out_size += sizeof(*req) + EC_BATCH_ALIGN(cmds[n].outsize);
+		in_size += sizeof(struct ec_batch_response) +
+			EC_BATCH_ALIGN(cmds[n].insize);
+	}
+	p->count = n;
+
+	if (!n) {
+		/* Too big to batch */
+		rv = send_one(cmds);
+		goto done;
+	}
+
+	rv = ec_command(EC_CMD_BATCH, 0, out, out_size, in, in_size);
+	if (rv < 0)
+		goto done;
+
+	r = (struct ec_response_batch *)in;
+	if (rv < sizeof(*r) || !r->count || r->count > n) {
+		rv = -EECRESULT - EC_RES_INVALID_RESPONSE;
+		goto done;
+	}
+
+	in_size = sizeof(*r);
+	for (i = 0; i < r->count; i++) {
+		struct ec_batch_response *resp =
+			(struct ec_batch_response *)(in + in_size);
+
+		if (in_size + sizeof(*resp) > rv ||
+		    in_size + sizeof(*resp) + resp->size > rv) {
+			rv = -EECRESULT - EC_RES_INVALID_RESPONSE;
+			goto done;
+		}
+
+		if (resp->result != EC_RES_SUCCESS) {
+			cmds[i].rv = -EECRESULT - resp->result;
+		} else {
+			cmds[i].rv = resp->size < cmds[i].insize ?
+				resp->size : cmds[i].insize;
+			memcpy(cmds[i].indata, resp + 1, cmds[i].rv);
+		}
+		in_size += sizeof(*resp) + EC_BATCH_ALIGN(resp->size);
+	}
+	rv = r->count;
+
+done:
+	free(out);
+	free(in);
+	return rv;
+}
+
+int ec_command_batch(struct ec_batch_cmd *cmds, int count)
+{
+	int i, rv;
+
+	while (count > 0) {
+		if (batch_supported) {
+			rv = send_batch(cmds, count);
+			if (rv == -EECRESULT - EC_RES_INVALID_COMMAND) {
+				batch_supported = 0;
+				continue;
+			}
+		} else {
+			rv = send_one(cmds);
+		}
+
+		if (rv < 0) {
+			for (i = 0; i < count; i++)
+				cmds[i].rv = rv;
+			return rv;
+		}
+
+		cmds += rv;
+		count -= rv;
+	}
+
+	return 0;
+}
+
+/* Cleared if the EC turns out not to support EC_CMD_MEMMAP_SNAPSHOT */
+static int snapshot_supported = 1;
+
+/* Times to try reading the memory map before giving up */
+#define SNAPSHOT_TRIES 10
+
+/* Snapshot the memory map by reading it directly */
+static int read_snapshot(int offset, int bytes, void *dest, int *seq)
+{
+	uint8_t start[2], end;
+	int i, pos, chunk, rv;
+
+	for (i = 0; i < SNAPSHOT_TRIES; i++) {
+		if (i)
+			usleep(1000);
+
+		/* Sequence number and busy count */
+		rv = ec_readmem(EC_MEMMAP_UPDATE_SEQ, sizeof(start), start);
+		if (rv < 0)
+			return rv;
+		if (start[1])
+			continue;
+		if (seq && *seq == start[0])
+			return 0;
+
+		/* Read in pieces the transport can handle */
+		for (pos = 0; pos < bytes; pos += chunk) {
+			chunk = bytes - pos < ec_max_insize ?
+				bytes - pos : ec_max_insize;
+			rv = ec_readmem(offset + pos, chunk,
+					(uint8_t *)dest + pos);
+			if (rv < 0)
+				return rv;
+		}
+		rv = ec_readmem(EC_MEMMAP_UPDATE_SEQ, sizeof(end), &end);
+		if (rv < 0)
+			return rv;
+		if (end == start[0]) {
+			if (seq)
+				*seq = end;
+			return bytes;
+		}
+	}
+
+	return -EC_RES_BUSY;
+}
+
+int ec_memmap_snapshot(int offset, int bytes, void *dest, int *seq)
+{
+	struct ec_params_memmap_snapshot p;
+	uint8_t buf[sizeof(struct ec_response_memmap_snapshot) +
+		    EC_MEMMAP_SIZE];
+	struct ec_response_memmap_snapshot *r =
+		(struct ec_response_memmap_snapshot *)buf;
+	int rv;
+
+	if (bytes <= 0 || offset < 0 || offset + bytes > EC_MEMMAP_SIZE)
+		return -EC_RES_INVALID_PARAM;
+
+	/* Fall back to reading the memory map if the command can't do it */
+	if (!snapshot_supported || sizeof(*r) + bytes > ec_max_insize)
+		return read_snapshot(offset, bytes, dest, seq);
+
+	p.offset = offset;
+	p.size = bytes;
+	p.flags = seq && *seq >= 0 ? EC_MEMMAP_SNAPSHOT_IF_CHANGED : 0;
+	p.seq = seq && *seq >= 0 ? *seq : 0;
+	rv = ec_command(EC_CMD_MEMMAP_SNAPSHOT, 0, &p, sizeof(p),
+			buf, sizeof(*r) + bytes);
+	if (rv == -EECRESULT - EC_RES_INVALID_COMMAND) {
+		snapshot_supported = 0;
+		return read_snapshot(offset, bytes, dest, seq);
+	}
+	if (rv < 0)
+		return rv;
+	if (rv < sizeof(*r))
+		return -EC_RES_INVALID_RESPONSE;
+
+	if (seq)
+		*seq = r->seq;
+	if (r->flags & EC_MEMMAP_SNAPSHOT_UNCHANGED)
+		return 0;
+	if (rv != sizeof(*r) + bytes)
+		return -EC_RES_INVALID_RESPONSE;
+
+	memcpy(dest, r->data, bytes);
+	return bytes;
+}
+
 int comm_init(int interfaces, const char *device_name)
 {
 	struct ec_response_get_protocol_info info;
@@ -104,6 +331,11 @@ int comm_init(int interfaces, const char *device_name)
 	if ((interfaces & COMM_I2C) && comm_init_i2c && !comm_init_i2c())
 		goto init_ok;
 
+	/* Finally, try the EC emulator */
+	if ((interfaces & COMM_SOCKET) && comm_init_socket &&
+	    !comm_init_socket())
+		goto init_ok;
+
 	/* Give up */
 	fprintf(stderr, "Unable to establish host communication\n");
 	return 1;
@@ -120,12 +352,17 @@ int comm_init(int interfaces, const char *device_name)
 	/* read max request / response size from ec for protocol v3+ */
 	if (ec_command(EC_CMD_GET_PROTOCOL_INFO, 0, NULL, 0, &info,
 		sizeof(info)) == sizeof(info)) {
+		/* The packet sizes include the headers */
 		if ((allow_large_buffer) ||
-		    (info.max_request_packet_size < ec_max_outsize))
-			ec_max_outsize = info.max_request_packet_size;
+		    (info.max_request_packet_size -
+		     sizeof(struct ec_host_request) < ec_max_outsize))
+			ec_max_outsize = info.max_request_packet_size -
+				sizeof(struct ec_host_request);
 		if ((allow_large_buffer) ||
-		    (info.max_request_packet_size < ec_max_insize))
-			ec_max_insize = info.max_response_packet_size;
+		    (info.max_response_packet_size -
+		     sizeof(struct ec_host_response) < ec_max_insize))
+			ec_max_insize = info.max_response_packet_size -
+				sizeof(struct ec_host_response);
 
 		ec_outbuf = realloc(ec_outbuf, ec_max_outsize);
 		ec_inbuf = realloc(ec_inbuf, ec_max_insize);
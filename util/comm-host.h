@@ -30,6 +30,7 @@ enum comm_interface {
 	COMM_DEV = (1 << 0),
 	COMM_LPC = (1 << 1),
 	COMM_I2C = (1 << 2),
+	COMM_SOCKET = (1 << 3),
 	COMM_ALL = -1
 };
 
@@ -50,6 +51,32 @@ int ec_command(int command, int version,
 	       const void *outdata, int outsize,   /* to the EC */
 	       void *indata, int insize);	   /* from the EC */
 
+/* One command of a batch; see ec_command_batch() */
+struct ec_batch_cmd {
+	int command;
+	int version;
+	const void *outdata;	/* To the EC */
+	int outsize;
+	void *indata;		/* From the EC */
+	int insize;
+	/* Set by ec_command_batch() to what ec_command() would return */
+	int rv;
+};
+
+/**
+ * Send several commands to the EC, in as few requests as possible.
+ *
+ * Commands are run in order.  If the EC doesn't support EC_CMD_BATCH, they
+ * are sent one at a time instead.
+ *
+ * @param cmds		Commands to send; each one's rv is set.
+ * @param count		Number of commands.
+ * @return 0 if all the commands were sent, or negative if communication
+ *	   with the EC failed; commands after the failure have rv set to the
+ *	   same error.
+ */
+int ec_command_batch(struct ec_batch_cmd *cmds, int count);
+
 /**
  * Set the offset to be applied to the command number when ec_command() calls
  * ec_command_proto().
@@ -74,4 +101,23 @@ extern int (*ec_command_proto)(int command, int version,
  */
 extern int (*ec_readmem)(int offset, int bytes, void *dest);
 
+/**
+ * Read a consistent snapshot of part of the EC memory map.
+ *
+ * Unlike several ec_readmem() calls, the data can't be torn by the EC
+ * updating it at the same time.  Uses EC_CMD_MEMMAP_SNAPSHOT if the EC
+ * supports it, or else reads the memory map and retries if its update
+ * sequence number changed.
+ *
+ * @param offset	Offset in the memory map (EC_MEMMAP_*)
+ * @param bytes		Number of bytes to read
+ * @param dest		Destination buffer
+ * @param seq		If not NULL, the sequence number of an earlier
+ *			snapshot (or -1); nothing is read if the memory map
+ *			hasn't changed since.  Set to that of this snapshot.
+ * @return bytes if the data was read, 0 if nothing changed, or negative if
+ *	   error.
+ */
+int ec_memmap_snapshot(int offset, int bytes, void *dest, int *seq);
+
 #endif /* __UTIL_COMM_HOST_H */
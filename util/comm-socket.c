@@ -0,0 +1,221 @@
+/* Copyright 2015 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Host commands over a Unix socket, for talking to the EC emulator (see
+ * chip/host/host_socket.c).  Packets are protocol version 3, as they would
+ * be on the bus.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "comm-host.h"
+#include "ec_commands.h"
+
+/* Socket to use, if not the default */
+#define EC_SOCKET_ENV "CROS_EC_SOCKET"
+#define EC_SOCKET_DEFAULT "/tmp/cros_ec.sock"
+
+/* Must match chip/host/host_socket.c */
+#define EC_SOCKET_PACKET_SIZE 0x100
+
+/* How long to wait for a command which finishes in the background */
+#define IN_PROGRESS_POLL_US 10000
+#define IN_PROGRESS_TIMEOUT_US 10000000
+
+static int sock_fd = -1;
+
+static int write_all(const void *buf, int size)
+{
+	const uint8_t *d = buf;
+	int rv;
+
+	while (size) {
+		rv = write(sock_fd, d, size);
+		if (rv < 0 && errno == EINTR)
+			continue;
+		if (rv <= 0)
+			return -1;
+		d += rv;
+		size -= rv;
+	}
+	return 0;
+}
+
+static int read_all(void *buf, int size)
+{
+	uint8_t *d = buf;
+	int rv;
+
+	while (size) {
+		rv = read(sock_fd, d, size);
+		if (rv < 0 && errno == EINTR)
+			continue;
+		if (rv <= 0)
+			return -1;
+		d += rv;
+		size -= rv;
+	}
+	return 0;
+}
+
+/*
+ * Send one packet and read back the response.
+ *
+ * Returns the EC result code, or negative if error.
+ */
+static int send_packet(int command, int version,
+		       const void *outdata, int outsize,
+		       void *indata, int insize, int *insize_out)
+{
+	uint8_t buf[EC_SOCKET_PACKET_SIZE];
+	struct ec_host_request *rq = (struct ec_host_request *)buf;
+	struct ec_host_response rs;
+	const uint8_t *d;
+	int csum = 0;
+	int i;
+
+	/* Fail if output size is too big */
+	if (outsize + sizeof(*rq) > sizeof(buf))
+		return -EC_RES_REQUEST_TRUNCATED;
+
+	rq->struct_version = EC_HOST_REQUEST_VERSION;
+	rq->checksum = 0;
+	rq->command = command;
+	rq->command_version = version;
+	rq->reserved = 0;
+	rq->data_len = outsize;
+	memcpy(rq + 1, outdata, outsize);
+
+	/* Write checksum field so the entire packet sums to 0 */
+	for (i = 0; i < sizeof(*rq) + outsize; i++)
+		csum += buf[i];
+	rq->checksum = (uint8_t)(-csum);
+
+	if (write_all(buf, sizeof(*rq) + outsize)) {
+		perror("Unable to send EC command");
+		return -EC_RES_ERROR;
+	}
+
+	/* Read back the response header, then the data */
+	if (read_all(&rs, sizeof(rs))) {
+		perror("Unable to read EC response");
+		return -EC_RES_ERROR;
+	}
+
+	if (rs.struct_version != EC_HOST_RESPONSE_VERSION) {
+		fprintf(stderr, "EC response version mismatch\n");
+		return -EC_RES_INVALID_RESPONSE;
+	}
+
+	if (rs.reserved || rs.data_len + sizeof(rs) > sizeof(buf)) {
+		fprintf(stderr, "EC response header is invalid\n");
+		return -EC_RES_INVALID_RESPONSE;
+	}
+
+	if (read_all(buf, rs.data_len)) {
+		perror("Unable to read EC response");
+		return -EC_RES_ERROR;
+	}
+
+	csum = 0;
+	for (i = 0, d = (const uint8_t *)&rs; i < sizeof(rs); i++, d++)
+		csum += *d;
+	for (i = 0; i < rs.data_len; i++)
+		csum += buf[i];
+	if ((uint8_t)csum) {
+		fprintf(stderr, "EC response has invalid checksum\n");
+		return -EC_RES_INVALID_CHECKSUM;
+	}
+
+	if (rs.data_len > insize) {
+		fprintf(stderr, "EC returned too much data\n");
+		return -EC_RES_RESPONSE_TOO_BIG;
+	}
+
+	memcpy(indata, buf, rs.data_len);
+	*insize_out = rs.data_len;
+	return rs.result;
+}
+
+static int ec_command_socket(int command, int version,
+			     const void *outdata, int outsize,
+			     void *indata, int insize)
+{
+	struct ec_response_get_comms_status status;
+	int size;
+	int rv;
+	int t;
+
+	rv = send_packet(command, version, outdata, outsize,
+			 indata, insize, &size);
+
+	/* Wait for commands which finish in the background */
+	for (t = 0; rv == EC_RES_IN_PROGRESS; t += IN_PROGRESS_POLL_US) {
+		if (t >= IN_PROGRESS_TIMEOUT_US) {
+			fprintf(stderr, "Timeout waiting for EC command\n");
+			return -EC_RES_TIMEOUT;
+		}
+		usleep(IN_PROGRESS_POLL_US);
+
+		rv = send_packet(EC_CMD_GET_COMMS_STATUS, 0, NULL, 0,
+				 &status, sizeof(status), &size);
+		if (rv)
+			break;
+		if (status.flags & EC_COMMS_STATUS_PROCESSING)
+			rv = EC_RES_IN_PROGRESS;
+		else
+			rv = send_packet(EC_CMD_RESEND_RESPONSE, 0, NULL, 0,
+					 indata, insize, &size);
+	}
+
+	if (rv < 0)
+		return rv;
+	if (rv) {
+		fprintf(stderr, "EC returned error result code %d\n", rv);
+		return -EECRESULT - rv;
+	}
+
+	/* Return actual amount of data received */
+	return size;
+}
+
+int comm_init_socket(void)
+{
+	struct sockaddr_un addr;
+	const char *path = getenv(EC_SOCKET_ENV);
+
+	if (!path || !*path)
+		path = EC_SOCKET_DEFAULT;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path))
+		return 1;
+	strcpy(addr.sun_path, path);
+
+	sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock_fd < 0)
+		return 2;
+
+	if (connect(sock_fd, (struct sockaddr *)&addr, sizeof(addr))) {
+		close(sock_fd);
+		sock_fd = -1;
+		return 3;
+	}
+
+	ec_command_proto = ec_command_socket;
+	ec_max_outsize = EC_SOCKET_PACKET_SIZE -
+		sizeof(struct ec_host_request);
+	ec_max_insize = EC_SOCKET_PACKET_SIZE -
+		sizeof(struct ec_host_response);
+
+	return 0;
+}
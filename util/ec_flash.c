@@ -8,9 +8,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "comm-host.h"
 #include "misc_util.h"
+#include "sha256.h"
+
+/* How long to wait for the EC to hash flash */
+#define HASH_POLL_US 10000
+#define HASH_TIMEOUT_US 10000000
 
 int ec_flash_read(uint8_t *buf, int offset, int size)
 {
@@ -34,12 +40,68 @@ int ec_flash_read(uint8_t *buf, int offset, int size)
 	return 0;
 }
 
+int ec_flash_verify_hash(const uint8_t *buf, int offset, int size)
+{
+	struct ec_params_vboot_hash p;
+	struct ec_response_vboot_hash r;
+	struct sha256_ctx ctx;
+	const uint8_t *digest;
+	int rv;
+	int t;
+
+	memset(&p, 0, sizeof(p));
+	p.cmd = EC_VBOOT_HASH_START;
+	p.hash_type = EC_VBOOT_HASH_TYPE_SHA256;
+	p.offset = offset;
+	p.size = size;
+	rv = ec_command(EC_CMD_VBOOT_HASH, 0, &p, sizeof(p), &r, sizeof(r));
+	if (rv < 0)
+		return rv;
+
+	/* Hash the data here while the EC hashes the flash */
+	SHA256_init(&ctx);
+	SHA256_update(&ctx, buf, size);
+	digest = SHA256_final(&ctx);
+
+	p.cmd = EC_VBOOT_HASH_GET;
+	for (t = 0; r.status == EC_VBOOT_HASH_STATUS_BUSY; t += HASH_POLL_US) {
+		if (t >= HASH_TIMEOUT_US) {
+			fprintf(stderr, "Timeout waiting for EC hash\n");
+			return -EC_RES_TIMEOUT;
+		}
+		usleep(HASH_POLL_US);
+		rv = ec_command(EC_CMD_VBOOT_HASH, 0, &p, sizeof(p),
+				&r, sizeof(r));
+		if (rv < 0)
+			return rv;
+	}
+
+	/* Make sure it's our hash, not one somebody else asked for */
+	if (r.status != EC_VBOOT_HASH_STATUS_DONE ||
+	    r.hash_type != EC_VBOOT_HASH_TYPE_SHA256 ||
+	    r.digest_size != SHA256_DIGEST_SIZE ||
+	    r.offset != offset || r.size != size) {
+		fprintf(stderr, "EC hash failed\n");
+		return -EC_RES_ERROR;
+	}
+
+	return memcmp(r.hash_digest, digest, SHA256_DIGEST_SIZE) ? 1 : 0;
+}
+
 int ec_flash_verify(const uint8_t *buf, int offset, int size)
 {
-	uint8_t *rbuf = malloc(size);
+	uint8_t *rbuf;
 	int rv;
 	int i;
 
+	/*
+	 * Let the EC hash the flash.  Only read it back if that fails or
+	 * doesn't match, to find where the mismatch is.
+	 */
+	if (!ec_flash_verify_hash(buf, offset, size))
+		return 0;
+
+	rbuf = malloc(size);
 	if (!rbuf) {
 		fprintf(stderr, "Unable to allocate buffer.\n");
 		return -1;
@@ -125,3 +187,101 @@ int ec_flash_erase(int offset, int size)
 
 	return ec_command(EC_CMD_FLASH_ERASE, 0, &p, sizeof(p), NULL, 0);
 }
+
+/* Return non-zero if size bytes at data are all erased */
+static int is_erased(const uint8_t *data, int size)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		if (data[i] != 0xff)
+			return 0;
+	}
+	return 1;
+}
+
+int ec_flash_write_delta(const uint8_t *buf, int offset, int size)
+{
+	struct ec_response_flash_info info;
+	uint8_t *old, *new;
+	int start, end, block, len;
+	int blocks = 0, changed = 0;
+	int run, i;
+	int rv;
+
+	rv = ec_command(EC_CMD_FLASH_INFO, 0, NULL, 0, &info, sizeof(info));
+	if (rv < 0)
+		return rv;
+
+	block = info.erase_block_size;
+	if (block <= 0 || info.write_block_size <= 0) {
+		fprintf(stderr, "Bad flash block size\n");
+		return -1;
+	}
+
+	/* Widen the range to whole erase blocks */
+	start = offset - offset % block;
+	end = offset + size + block - 1;
+	end -= end % block;
+	if (end > info.flash_size) {
+		fprintf(stderr, "Write past end of flash\n");
+		return -1;
+	}
+
+	old = malloc(2 * (end - start));
+	if (!old) {
+		fprintf(stderr, "Unable to allocate buffer.\n");
+		return -1;
+	}
+	new = old + end - start;
+
+	/*
+	 * Read back what's there now.  The new contents are the same, with
+	 * the data laid over it.
+	 */
+	rv = ec_flash_read(old, start, end - start);
+	if (rv < 0)
+		goto out;
+	memcpy(new, old, end - start);
+	memcpy(new + offset - start, buf, size);
+
+	for (i = 0; i < end - start; i = run) {
+		blocks++;
+		run = i + block;
+		if (!memcmp(old + i, new + i, block))
+			continue;
+
+		/* Coalesce the run of changed blocks starting here */
+		while (run < end - start &&
+		       memcmp(old + run, new + run, block)) {
+			blocks++;
+			run += block;
+		}
+		changed += (run - i) / block;
+
+		rv = ec_flash_erase(start + i, run - i);
+		if (rv < 0) {
+			fprintf(stderr, "Erase error at offset %d\n",
+				start + i);
+			goto out;
+		}
+
+		/* Erased flash reads as 0xff, so don't write the padding */
+		for (len = run - i; len > 0; len -= info.write_block_size) {
+			if (!is_erased(new + i + len - info.write_block_size,
+				       info.write_block_size))
+				break;
+		}
+		if (len > 0) {
+			rv = ec_flash_write(new + i, start + i, len);
+			if (rv < 0)
+				goto out;
+		}
+	}
+
+	printf("Rewrote %d of %d blocks\n", changed, blocks);
+	rv = 0;
+out:
+	free(old);
+	return rv;
+}
@@ -17,9 +17,26 @@
  */
 int ec_flash_read(uint8_t *buf, int offset, int size);
 
+/**
+ * Verify EC flash memory against a hash computed by the EC
+ *
+ * Uses EC_CMD_VBOOT_HASH to have the EC hash the flash, which is much
+ * faster than reading it back.  This replaces the EC's last computed hash.
+ *
+ * @param buf		Source buffer to verify against EC flash
+ * @param offset	Offset in EC flash to check
+ * @param size		Number of bytes to check
+ *
+ * @return 0 if the hashes match, 1 if they don't, negative if error.
+ */
+int ec_flash_verify_hash(const uint8_t *buf, int offset, int size);
+
 /**
  * Verify EC flash memory
  *
+ * Compares hashes if the EC can compute one, and only reads the flash back
+ * to find the mismatch if they differ.
+ *
  * @param buf		Source buffer to verify against EC flash
  * @param offset	Offset in EC flash to check
  * @param size		Number of bytes to check
@@ -39,6 +56,21 @@ int ec_flash_verify(const uint8_t *buf, int offset, int size);
  */
 int ec_flash_write(const uint8_t *buf, int offset, int size);
 
+/**
+ * Write EC flash memory, rewriting only the erase blocks which change
+ *
+ * Reads back the erase blocks the data falls in, then erases and writes
+ * only the runs of blocks whose contents differ.  Unlike ec_flash_write(),
+ * the flash does not need to be erased first.
+ *
+ * @param buf		Source buffer
+ * @param offset	Offset in EC flash to write
+ * @param size		Number of bytes to write
+ *
+ * @return 0 if success, negative if error.
+ */
+int ec_flash_write_delta(const uint8_t *buf, int offset, int size);
+
 /**
  * Erase EC flash memory
  *
@@ -67,8 +67,11 @@ const char help_str[] =
 	"      Prints chip info\n"
 	"  cmdversions <cmd>\n"
 	"      Prints supported version mask for a command number\n"
-	"  console\n"
-	"      Prints the last output to the EC debug console\n"
+	"  console [--follow]\n"
+	"      Prints the last output to the EC debug console; with --follow,\n"
+	"      keeps printing new output until interrupted\n"
+	"  consolebinlog <outfile>\n"
+	"      Saves the EC binary console log, for util/binlog_decode.py\n"
 	"  echash [CMDS]\n"
 	"      Various EC hash commands\n"
 	"  eventclear <mask>\n"
@@ -105,8 +108,11 @@ const char help_str[] =
 	"      Prints or sets EC flash protection state\n"
 	"  flashread <offset> <size> <outfile>\n"
 	"      Reads from EC flash to a file\n"
-	"  flashwrite <offset> <infile>\n"
-	"      Writes to EC flash from a file\n"
+	"  flashverify <offset> <infile>\n"
+	"      Verifies EC flash against a file\n"
+	"  flashwrite [--delta] <offset> <infile>\n"
+	"      Writes to EC flash from a file; with --delta, erases and\n"
+	"      rewrites only the blocks which change\n"
 	"  forcelidopen <enable>\n"
 	"      Forces the lid switch to open position\n"
 	"  gpioget <GPIO name>\n"
@@ -115,6 +121,8 @@ const char help_str[] =
 	"      Set the value of GPIO signal\n"
 	"  hangdetect <flags> <event_msec> <reboot_msec> | stop | start\n"
 	"      Configure or start/stop the hang detect timer\n"
+	"  hcstats [reset]\n"
+	"      Prints (then optionally resets) EC host command statistics\n"
 	"  hello\n"
 	"      Checks for basic communication with EC\n"
 	"  kbpress\n"
@@ -187,6 +195,8 @@ const char help_str[] =
 	"      Serial output test for COM2\n"
 	"  switches\n"
 	"      Prints current EC switch positions\n"
+	"  taskstats [reset]\n"
+	"      Prints (and optionally resets) task latency histograms\n"
 	"  temps <sensorid>\n"
 	"      Print temperature.\n"
 	"  tempsinfo <sensorid>\n"
@@ -248,7 +258,7 @@ int parse_bool(const char *s, int *dest)
 
 void print_help(const char *prog, int print_cmds)
 {
-	printf("Usage: %s [--dev=n] [--interface=dev|lpc|i2c] ", prog);
+	printf("Usage: %s [--dev=n] [--interface=dev|lpc|i2c|socket] ", prog);
 	printf("[--name=cros_ec|cros_sh|cros_pd] <command> [params]\n\n");
 	if (print_cmds)
 		puts(help_str);
@@ -295,18 +305,6 @@ static uint32_t read_mapped_mem32(uint8_t offset)
 	return val;
 }
 
-static int read_mapped_string(uint8_t offset, char *buffer, int max_size)
-{
-	int ret;
-
-	ret = ec_readmem(offset, max_size, buffer);
-	if (ret <= 0) {
-		fprintf(stderr, "failure in %s(): %d\n", __func__, ret);
-		exit(1);
-	}
-	return ret;
-}
-
 int cmd_hello(int argc, char *argv[])
 {
 	struct ec_params_hello p;
@@ -713,7 +711,7 @@ int cmd_flash_read(int argc, char *argv[])
 	return 0;
 }
 
-int cmd_flash_write(int argc, char *argv[])
+int cmd_flash_verify(int argc, char *argv[])
 {
 	int offset, size;
 	int rv;
@@ -736,10 +734,54 @@ int cmd_flash_write(int argc, char *argv[])
 	if (!buf)
 		return -1;
 
+	printf("Verifying offset %d...\n", offset);
+
+	rv = ec_flash_verify((const uint8_t *)buf, offset, size);
+
+	free(buf);
+
+	if (rv < 0)
+		return rv;
+
+	printf("done.\n");
+	return 0;
+}
+
+int cmd_flash_write(int argc, char *argv[])
+{
+	int offset, size;
+	int delta = 0;
+	int rv;
+	char *e;
+	char *buf;
+
+	if (argc > 1 && !strcmp(argv[1], "--delta"))
+		delta = 1;
+
+	if (argc < 3 + delta) {
+		fprintf(stderr, "Usage: %s [--delta] <offset> <filename>\n",
+			argv[0]);
+		return -1;
+	}
+
+	offset = strtol(argv[1 + delta], &e, 0);
+	if ((e && *e) || offset < 0 || offset > 0x100000) {
+		fprintf(stderr, "Bad offset.\n");
+		return -1;
+	}
+
+	/* Read the input file */
+	buf = read_file(argv[2 + delta], &size);
+	if (!buf)
+		return -1;
+
 	printf("Writing to offset %d...\n", offset);
 
 	/* Write data in chunks */
-	rv = ec_flash_write(buf, offset, size);
+	if (delta)
+		rv = ec_flash_write_delta(buf, offset, size);
+	else
+		rv = ec_flash_write(buf, offset, size);
 
 	free(buf);
 
@@ -4522,6 +4564,130 @@ int cmd_switches(int argc, char *argv[])
 }
 
 
+static void print_task_stats_header(const char *title)
+{
+	int b;
+
+	printf("%s (us):\n%-12s", title, "Task");
+	for (b = 0; b < EC_TASK_STATS_BUCKETS - 1; b++) {
+		if (b < 11)
+			printf(" %5d", 1 << b);
+		else
+			printf(" %4dK", 1 << (b - 10));
+	}
+	printf("  more\n");
+}
+
+static void print_task_stats_row(const struct ec_response_task_stats *r,
+				 int run_time)
+{
+	int b;
+
+	printf("%-12.*s", (int)sizeof(r->name), r->name);
+	for (b = 0; b < EC_TASK_STATS_BUCKETS; b++)
+		printf(" %5d", run_time ? r->run_time[b] : r->wake_latency[b]);
+	printf("\n");
+}
+
+int cmd_task_stats(int argc, char *argv[])
+{
+	struct ec_params_task_stats p;
+	struct ec_response_task_stats r;
+	struct ec_response_task_stats *all;
+	int count, i, rv;
+	int reset = 0;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset")) {
+			fprintf(stderr, "Usage: %s [reset]\n", argv[0]);
+			return -1;
+		}
+		reset = 1;
+	}
+
+	/* The first response says how many tasks there are */
+	p.task_id = 0;
+	p.flags = 0;
+	rv = ec_command(EC_CMD_TASK_STATS, 0, &p, sizeof(p), &r, sizeof(r));
+	if (rv < 0)
+		return rv;
+
+	count = r.task_count;
+	all = calloc(count, sizeof(*all));
+	if (!all) {
+		fprintf(stderr, "Unable to allocate buffer.\n");
+		return -1;
+	}
+
+	/* Only reset on the last query, once every task has been read */
+	for (i = 0; i < count; i++) {
+		p.task_id = i;
+		p.flags = (reset && i == count - 1) ?
+			EC_TASK_STATS_FLAG_RESET : 0;
+		rv = ec_command(EC_CMD_TASK_STATS, 0, &p, sizeof(p),
+				&all[i], sizeof(all[i]));
+		if (rv < 0)
+			goto out;
+	}
+
+	print_task_stats_header("Wake-up latency, under");
+	for (i = 0; i < count; i++)
+		print_task_stats_row(&all[i], 0);
+	print_task_stats_header("Run time, under");
+	for (i = 0; i < count; i++)
+		print_task_stats_row(&all[i], 1);
+	rv = 0;
+out:
+	free(all);
+	return rv;
+}
+
+int cmd_host_command_stats(int argc, char *argv[])
+{
+	struct ec_params_host_command_stats p;
+	struct ec_response_host_command_stats r;
+	int count, i, rv;
+	int reset = 0;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset")) {
+			fprintf(stderr, "Usage: %s [reset]\n", argv[0]);
+			return -1;
+		}
+		reset = 1;
+	}
+
+	/* The first response says how many commands there are */
+	p.index = 0;
+	p.flags = 0;
+	p.reserved = 0;
+	rv = ec_command(EC_CMD_HOST_COMMAND_STATS, 0, &p, sizeof(p),
+			&r, sizeof(r));
+	if (rv < 0)
+		return rv;
+	count = r.count;
+
+	printf("Cmd      Calls  Errors   Max us   Avg us     Total us\n");
+	for (i = 0; i < count; i++) {
+		/* Only reset on the last query, once every command is read */
+		p.index = i;
+		p.flags = (reset && i == count - 1) ?
+			EC_HOST_COMMAND_STATS_FLAG_RESET : 0;
+		rv = ec_command(EC_CMD_HOST_COMMAND_STATS, 0, &p, sizeof(p),
+				&r, sizeof(r));
+		if (rv < 0)
+			return rv;
+
+		if (!r.calls)
+			continue;
+		printf("0x%04x %7u %7u %8u %8u %12" PRIu64 "\n", r.command,
+		       r.calls, r.errors, r.max_time,
+		       (uint32_t)(r.total_time / r.calls), r.total_time);
+	}
+
+	return 0;
+}
+
 int cmd_wireless(int argc, char *argv[])
 {
 	char *e;
@@ -5193,8 +5359,28 @@ int cmd_gpio_set(int argc, char *argv[])
 }
 
 
+/* Battery info is read in one snapshot, so the values match each other */
+#define BATT_MEMMAP_SIZE \
+	(EC_MEMMAP_BATT_TYPE + EC_MEMMAP_TEXT_MAX - EC_MEMMAP_BATT_VOLT)
+
+static uint32_t batt_mem32(const uint8_t *batt, int offset)
+{
+	uint32_t val;
+
+	memcpy(&val, batt + offset - EC_MEMMAP_BATT_VOLT, sizeof(val));
+	return val;
+}
+
+static int batt_string(const uint8_t *batt, int offset, char *buffer)
+{
+	memcpy(buffer, batt + offset - EC_MEMMAP_BATT_VOLT, EC_MEMMAP_TEXT_MAX);
+	buffer[EC_MEMMAP_TEXT_MAX - 1] = '\0';
+	return strlen(buffer);
+}
+
 int cmd_battery(int argc, char *argv[])
 {
+	uint8_t batt[BATT_MEMMAP_SIZE];
 	char batt_text[EC_MEMMAP_TEXT_MAX];
 	int rv, val;
 
@@ -5204,66 +5390,68 @@ int cmd_battery(int argc, char *argv[])
 		return -1;
 	}
 
+	rv = ec_memmap_snapshot(EC_MEMMAP_BATT_VOLT, sizeof(batt), batt, NULL);
+	if (rv < 0) {
+		fprintf(stderr, "Failed to read battery info: %d\n", rv);
+		return rv;
+	}
+
 	printf("Battery info:\n");
 
-	rv = read_mapped_string(EC_MEMMAP_BATT_MFGR, batt_text,
-			sizeof(batt_text));
+	rv = batt_string(batt, EC_MEMMAP_BATT_MFGR, batt_text);
 	if (rv < 0 || !is_string_printable(batt_text))
 		goto cmd_error;
 	printf("  OEM name:               %s\n", batt_text);
 
-	rv = read_mapped_string(EC_MEMMAP_BATT_MODEL, batt_text,
-			sizeof(batt_text));
+	rv = batt_string(batt, EC_MEMMAP_BATT_MODEL, batt_text);
 	if (rv < 0 || !is_string_printable(batt_text))
 		goto cmd_error;
 	printf("  Model number:           %s\n", batt_text);
 
-	rv = read_mapped_string(EC_MEMMAP_BATT_TYPE, batt_text,
-			sizeof(batt_text));
+	rv = batt_string(batt, EC_MEMMAP_BATT_TYPE, batt_text);
 	if (rv < 0 || !is_string_printable(batt_text))
 		goto cmd_error;
 	printf("  Chemistry   :           %s\n", batt_text);
 
-	rv = read_mapped_string(EC_MEMMAP_BATT_SERIAL, batt_text,
-			sizeof(batt_text));
+	rv = batt_string(batt, EC_MEMMAP_BATT_SERIAL, batt_text);
 	printf("  Serial number:          %s\n", batt_text);
 
-	val = read_mapped_mem32(EC_MEMMAP_BATT_DCAP);
+	val = batt_mem32(batt, EC_MEMMAP_BATT_DCAP);
 	if (!is_battery_range(val))
 		goto cmd_error;
 	printf("  Design capacity:        %u mAh\n", val);
 
-	val = read_mapped_mem32(EC_MEMMAP_BATT_LFCC);
+	val = batt_mem32(batt, EC_MEMMAP_BATT_LFCC);
 	if (!is_battery_range(val))
 		goto cmd_error;
 	printf("  Last full charge:       %u mAh\n", val);
 
-	val = read_mapped_mem32(EC_MEMMAP_BATT_DVLT);
+	val = batt_mem32(batt, EC_MEMMAP_BATT_DVLT);
 	if (!is_battery_range(val))
 		goto cmd_error;
 	printf("  Design output voltage   %u mV\n", val);
 
-	val = read_mapped_mem32(EC_MEMMAP_BATT_CCNT);
+	val = batt_mem32(batt, EC_MEMMAP_BATT_CCNT);
 	if (!is_battery_range(val))
 		goto cmd_error;
 	printf("  Cycle count             %u\n", val);
 
-	val = read_mapped_mem32(EC_MEMMAP_BATT_VOLT);
+	val = batt_mem32(batt, EC_MEMMAP_BATT_VOLT);
 	if (!is_battery_range(val))
 		goto cmd_error;
 	printf("  Present voltage         %u mV\n", val);
 
-	val = read_mapped_mem32(EC_MEMMAP_BATT_RATE);
+	val = batt_mem32(batt, EC_MEMMAP_BATT_RATE);
 	if (!is_battery_range(val))
 		goto cmd_error;
 	printf("  Present current         %u mA\n", val);
 
-	val = read_mapped_mem32(EC_MEMMAP_BATT_CAP);
+	val = batt_mem32(batt, EC_MEMMAP_BATT_CAP);
 	if (!is_battery_range(val))
 		goto cmd_error;
 	printf("  Remaining capacity      %u mAh\n", val);
 
-	val = read_mapped_mem8(EC_MEMMAP_BATT_FLAG);
+	val = batt[EC_MEMMAP_BATT_FLAG - EC_MEMMAP_BATT_VOLT];
 	printf("  Flags                   0x%02x", val);
 	if (val & EC_BATT_FLAG_AC_PRESENT)
 		printf(" AC_PRESENT");
@@ -5634,11 +5822,60 @@ int cmd_rtc_set(int argc, char *argv[])
 	return 0;
 }
 
+/* Print console output as it arrives, using a cursor into the EC buffer */
+static int console_follow(void)
+{
+	struct ec_params_console_read_v2 p;
+	struct ec_response_console_read_v2 *r =
+		(struct ec_response_console_read_v2 *)ec_inbuf;
+	int first = 1;
+	int rv;
+
+	if (!ec_cmd_version_supported(EC_CMD_CONSOLE_READ, 2)) {
+		fprintf(stderr, "EC does not support following the console\n");
+		return -1;
+	}
+
+	/* Start with whatever is still in the buffer */
+	p.cursor = 0;
+	while (1) {
+		rv = ec_command(EC_CMD_CONSOLE_READ, 2, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+		if (rv < sizeof(*r)) {
+			fprintf(stderr, "Invalid console read response\n");
+			return -1;
+		}
+		rv -= sizeof(*r);
+
+		if ((r->flags & EC_CONSOLE_READ_FLAG_OVERRUN) && !first)
+			fprintf(stderr, "\n[%u bytes of console output lost]\n",
+				r->cursor - p.cursor);
+		first = 0;
+
+		fwrite(r->data, 1, rv, stdout);
+		fflush(stdout);
+		p.cursor = r->cursor + rv;
+
+		/* Poll again once there's new output */
+		if (p.cursor == r->end)
+			usleep(100000);
+	}
+}
+
 int cmd_console(int argc, char *argv[])
 {
 	char *out = (char *)ec_inbuf;
 	int rv;
 
+	if (argc > 1) {
+		if (argc == 2 && !strcmp(argv[1], "--follow"))
+			return console_follow();
+		fprintf(stderr, "Usage: %s [--follow]\n", argv[0]);
+		return -1;
+	}
+
 	/* Snapshot the EC console */
 	rv = ec_command(EC_CMD_CONSOLE_SNAPSHOT, 0, NULL, 0, NULL, 0);
 	if (rv < 0)
@@ -5662,6 +5899,69 @@ int cmd_console(int argc, char *argv[])
 	printf("\n");
 	return 0;
 }
+
+int cmd_console_binlog(int argc, char *argv[])
+{
+	struct ec_params_console_binlog_read p;
+	struct ec_response_console_binlog_read *r =
+		(struct ec_response_console_binlog_read *)ec_inbuf;
+	char *buf = NULL, *new_buf;
+	int size = sizeof(r->format_base);
+	uint32_t end = 0;
+	int first = 1;
+	int rv;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <outfile>\n", argv[0]);
+		return -1;
+	}
+
+	/* The file is the format string base, followed by the records */
+	p.offset = 0;
+	do {
+		rv = ec_command(EC_CMD_CONSOLE_BINLOG_READ, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			goto out;
+		if (rv < sizeof(*r)) {
+			fprintf(stderr, "Invalid console binlog response\n");
+			rv = -1;
+			goto out;
+		}
+		rv -= sizeof(*r);
+
+		new_buf = realloc(buf, size + rv);
+		if (!new_buf) {
+			fprintf(stderr, "Unable to allocate buffer.\n");
+			rv = -1;
+			goto out;
+		}
+		buf = new_buf;
+		memcpy(buf, &r->format_base, sizeof(r->format_base));
+		memcpy(buf + size, r->data, rv);
+		size += rv;
+
+		/*
+		 * Stop at the end of the log as it was when we started, so an
+		 * EC which keeps logging can't keep us reading forever.
+		 */
+		if (first)
+			end = r->head;
+		first = 0;
+		if (r->next == p.offset)
+			break;
+		p.offset = r->next;
+	} while ((int32_t)(end - r->next) > 0);
+
+	rv = write_file(argv[1], buf, size);
+	if (rv == 0)
+		printf("Saved %d bytes of records.\n",
+		       size - (int)sizeof(r->format_base));
+out:
+	free(buf);
+	return rv < 0 ? rv : 0;
+}
+
 struct param_info {
 	const char *name;	/* name of this parameter */
 	const char *help;	/* help message */
@@ -6348,6 +6648,7 @@ const struct command commands[] = {
 	{"chipinfo", cmd_chipinfo},
 	{"cmdversions", cmd_cmdversions},
 	{"console", cmd_console},
+	{"consolebinlog", cmd_console_binlog},
 	{"echash", cmd_ec_hash},
 	{"eventclear", cmd_host_event_clear},
 	{"eventclearb", cmd_host_event_clear_b},
@@ -6364,6 +6665,7 @@ const struct command commands[] = {
 	{"flasherase", cmd_flash_erase},
 	{"flashprotect", cmd_flash_protect},
 	{"flashread", cmd_flash_read},
+	{"flashverify", cmd_flash_verify},
 	{"flashwrite", cmd_flash_write},
 	{"flashinfo", cmd_flash_info},
 	{"flashpd", cmd_flash_pd},
@@ -6371,6 +6673,7 @@ const struct command commands[] = {
 	{"gpioget", cmd_gpio_get},
 	{"gpioset", cmd_gpio_set},
 	{"hangdetect", cmd_hang_detect},
+	{"hcstats", cmd_host_command_stats},
 	{"hello", cmd_hello},
 	{"kbpress", cmd_kbpress},
 	{"i2cread", cmd_i2c_read},
@@ -6409,6 +6712,7 @@ const struct command commands[] = {
 	{"sertest", cmd_serial_test},
 	{"port80flood", cmd_port_80_flood},
 	{"switches", cmd_switches},
+	{"taskstats", cmd_task_stats},
 	{"temps", cmd_temperature},
 	{"tempsinfo", cmd_temp_sensor_info},
 	{"test", cmd_test},
@@ -6438,7 +6742,8 @@ int main(int argc, char *argv[])
 
 	BUILD_ASSERT(ARRAY_SIZE(lb_command_paramcount) == LIGHTBAR_NUM_CMDS);
 
-	while ((i = getopt_long(argc, argv, "?", long_opts, NULL)) != -1) {
+	/* Stop at the command, so it can have options of its own */
+	while ((i = getopt_long(argc, argv, "+?", long_opts, NULL)) != -1) {
 		switch (i) {
 		case '?':
 			/* Unhandled option */
@@ -6460,6 +6765,8 @@ int main(int argc, char *argv[])
 				interfaces = COMM_LPC;
 			} else if (!strcasecmp(optarg, "i2c")) {
 				interfaces = COMM_I2C;
+			} else if (!strcasecmp(optarg, "socket")) {
+				interfaces = COMM_SOCKET;
 			} else {
 				fprintf(stderr, "Invalid --interface\n");
 				parse_error = 1;